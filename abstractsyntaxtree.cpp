@@ -0,0 +1,911 @@
+/*
+    Implementation of the AbstractSyntaxTree class
+    by: Kathy
+
+    Description: This file contains the implementations of
+    the AbstractSyntaxTree class functions declared in the
+    header file.
+*/
+
+#include <cstring>
+
+#include "abstractsyntaxtree.hpp"
+
+const unsigned int AbstractSyntaxTree::none;
+const unsigned int AbstractSyntaxTree::maxNestingDepth;
+
+/*
+    The precedences of the binary operators, a higher one is done
+    first. ^ is done right to left and the others left to right.
+*/
+static const int orPrecedence = 1;
+static const int andPrecedence = 2;
+static const int equalityPrecedence = 3;
+static const int comparisonPrecedence = 4;
+static const int additivePrecedence = 5;
+static const int multiplicativePrecedence = 6;
+static const int powerPrecedence = 7;
+
+/*
+    This is the default constructor for the AbstractSyntaxTree class.
+    The root node is initialized to none.
+*/
+AbstractSyntaxTree::AbstractSyntaxTree() {
+    root = none;
+    tokenizer = nullptr;
+    position = 0;
+    signTaken = false;
+    depth = 0;
+    whileWord = AtomTable::none;
+    forWord = AtomTable::none;
+    returnWord = AtomTable::none;
+    atoms = nullptr;
+    sourceMap = nullptr;
+    invalidSyntax = false;
+    errorLineNumber = 0;
+}
+
+/*
+    This function parses the token list into the tree. The first
+    syntax error found stops the parse and is kept for displayAST.
+*/
+void AbstractSyntaxTree::createAST(Tokenization& tokenizer) {
+    // if there were errors while tokenizing, return
+    if (tokenizer.invalidToken || tokenizer.tokenList.empty()) {
+        return;
+    }
+
+    this->tokenizer = &tokenizer;
+    atoms = &tokenizer.atoms;
+    sourceMap = &tokenizer.sourceMap;
+    position = 0;
+    signTaken = false;
+    depth = 0;
+    whileWord = tokenizer.atoms.intern("while");
+    forWord = tokenizer.atoms.intern("for");
+    returnWord = tokenizer.atoms.intern("return");
+
+    // there are fewer nodes than tokens
+    nodes.reserve(tokenizer.tokenList.size());
+    root = addNode(AstKind::PROGRAM, tokenizer.tokenList.front());
+
+    ChildList children;
+    while (position < tokenizer.tokenList.size()) {
+        if (check(TokenKind::KEYWORD_FUNCTION) || check(TokenKind::KEYWORD_PROCEDURE)) {
+            parseFunction(children);
+        }
+        else if (Tokenization::isDatatype(tokenizer.tokenList[position].kind)) {
+            parseDeclarations(children, AstKind::DECLARATION);
+        }
+        else {
+            fail("expected a declaration, function or procedure");
+        }
+    }
+    nodes[root].firstChild = children.first;
+}
+
+/*
+    This function adds a node for the token to the tree and returns
+    its index. The node has no children yet.
+*/
+unsigned int AbstractSyntaxTree::addNode(AstKind kind, const Token &token) {
+    AstNode node;
+    node.kind = kind;
+    node.type = token.kind;
+    node.isArray = false;
+    node.atom = AtomTable::none;
+    node.value = 0;
+    node.location = static_cast<unsigned int>(tokenizer->location(token));
+    node.firstChild = none;
+    node.nextSibling = none;
+    nodes.push_back(node);
+    return static_cast<unsigned int>(nodes.size() - 1);
+}
+
+/*
+    This function adds a node to the end of a list of children.
+*/
+void AbstractSyntaxTree::addChild(ChildList &children, unsigned int child) {
+    if (child == none) {
+        return;
+    }
+    if (children.first == none) {
+        children.first = child;
+    }
+    else {
+        nodes[children.last].nextSibling = child;
+    }
+    children.last = child;
+}
+
+/*
+    This function parses a function or procedure, from its reserved
+    word to the end of its body.
+*/
+void AbstractSyntaxTree::parseFunction(ChildList &children) {
+    const Token &keyword = tokenizer->tokenList[position];
+    bool isFunction = (keyword.kind == TokenKind::KEYWORD_FUNCTION);
+    unsigned int function = addNode(isFunction ? AstKind::FUNCTION : AstKind::PROCEDURE, keyword);
+    addChild(children, function);
+    position++;
+
+    // a function has the datatype it returns before its name
+    if (isFunction) {
+        if (position < tokenizer->tokenList.size() &&
+            (Tokenization::isDatatype(tokenizer->tokenList[position].kind) ||
+             check(TokenKind::KEYWORD_VOID))) {
+            nodes[function].type = tokenizer->tokenList[position].kind;
+            position++;
+        }
+        else {
+            fail("expected the datatype of the function");
+            return;
+        }
+    }
+    if (!check(TokenKind::IDENTIFIER)) {
+        fail(isFunction ? "expected the name of the function" : "expected the name of the procedure");
+        return;
+    }
+    nodes[function].atom = tokenizer->tokenList[position].atom;
+    position++;
+
+    ChildList functionChildren;
+    if (expect(TokenKind::LEFT_PARENTHESIS, "(")) {
+        parseParameters(functionChildren);
+        if (expect(TokenKind::RIGHT_PARENTHESIS, ")")) {
+            addChild(functionChildren, parseBlock());
+        }
+    }
+    nodes[function].firstChild = functionChildren.first;
+}
+
+/*
+    This function parses the parameters of a function or procedure,
+    which are void, nothing, or a list of datatypes and names.
+*/
+void AbstractSyntaxTree::parseParameters(ChildList &children) {
+    if (check(TokenKind::KEYWORD_VOID)) {
+        position++;
+        return;
+    }
+    if (check(TokenKind::RIGHT_PARENTHESIS)) {
+        return;
+    }
+
+    do {
+        if (position >= tokenizer->tokenList.size() ||
+            !Tokenization::isDatatype(tokenizer->tokenList[position].kind)) {
+            fail("expected the datatype of a parameter");
+            return;
+        }
+        parseDeclarations(children, AstKind::PARAMETER);
+    } while (!invalidSyntax && check(TokenKind::COMMA) && ++position);
+}
+
+/*
+    This function parses a datatype followed by names, each of which
+    may be an array with a size. A DECLARATION list ends with a ;,
+    a PARAMETER has one name.
+*/
+void AbstractSyntaxTree::parseDeclarations(ChildList &children, AstKind kind) {
+    TokenKind datatype = tokenizer->tokenList[position].kind;
+    position++;
+
+    do {
+        if (!check(TokenKind::IDENTIFIER)) {
+            fail("expected the name of a variable");
+            return;
+        }
+        unsigned int declaration = addNode(kind, tokenizer->tokenList[position]);
+        nodes[declaration].type = datatype;
+        nodes[declaration].atom = tokenizer->tokenList[position].atom;
+        addChild(children, declaration);
+        position++;
+
+        // an array has its size in brackets
+        if (check(TokenKind::LEFT_BRACKET)) {
+            position++;
+            if (!check(TokenKind::INTEGER)) {
+                fail("expected the size of the array");
+                return;
+            }
+            nodes[declaration].isArray = true;
+            nodes[declaration].value = tokenizer->tokenList[position].integerValue;
+            position++;
+            if (!expect(TokenKind::RIGHT_BRACKET, "]")) {
+                return;
+            }
+        }
+    } while (kind == AstKind::DECLARATION && check(TokenKind::COMMA) && ++position);
+
+    if (kind == AstKind::DECLARATION) {
+        expect(TokenKind::SEMICOLON, ";");
+    }
+}
+
+/*
+    This function parses a block of declarations and statements in
+    braces.
+*/
+unsigned int AbstractSyntaxTree::parseBlock() {
+    if (!check(TokenKind::LEFT_BRACE)) {
+        expect(TokenKind::LEFT_BRACE, "{");
+        return none;
+    }
+    unsigned int block = addNode(AstKind::BLOCK, tokenizer->tokenList[position]);
+    position++;
+
+    ChildList children;
+    while (position < tokenizer->tokenList.size() && !check(TokenKind::RIGHT_BRACE)) {
+        parseStatement(children);
+    }
+    expect(TokenKind::RIGHT_BRACE, "}");
+    nodes[block].firstChild = children.first;
+    return block;
+}
+
+/*
+    This function parses one statement, or the declarations of a
+    block, and adds its nodes to children. An empty statement adds
+    no node.
+*/
+void AbstractSyntaxTree::parseStatement(ChildList &children) {
+    if (position >= tokenizer->tokenList.size()) {
+        fail("expected a statement");
+        return;
+    }
+    // each statement inside another takes more of the stack, here and
+    // when the tree is displayed or run
+    if (depth >= maxNestingDepth) {
+        fail("statement is nested too deeply");
+        return;
+    }
+    depth++;
+
+    TokenKind kind = tokenizer->tokenList[position].kind;
+    if (kind == TokenKind::LEFT_BRACE) {
+        addChild(children, parseBlock());
+    }
+    else if (Tokenization::isDatatype(kind)) {
+        parseDeclarations(children, AstKind::DECLARATION);
+    }
+    else if (kind == TokenKind::KEYWORD_IF) {
+        addChild(children, parseIf());
+    }
+    else if (kind == TokenKind::KEYWORD_PRINTF) {
+        addChild(children, parsePrintf());
+    }
+    else if (checkWord(whileWord)) {
+        addChild(children, parseWhile());
+    }
+    else if (checkWord(forWord)) {
+        addChild(children, parseFor());
+    }
+    else if (checkWord(returnWord)) {
+        addChild(children, parseReturn());
+    }
+    else if (kind == TokenKind::SEMICOLON) {
+        position++;
+    }
+    else if (kind == TokenKind::IDENTIFIER) {
+        addChild(children, parseAssignmentOrCall());
+        expect(TokenKind::SEMICOLON, ";");
+    }
+    else {
+        fail("expected a statement");
+    }
+    depth--;
+}
+
+/*
+    This function parses the statement that is the body of an if,
+    else, while or for, which is an EMPTY node for a lone ;.
+*/
+unsigned int AbstractSyntaxTree::parseBody() {
+    if (check(TokenKind::SEMICOLON)) {
+        unsigned int empty = addNode(AstKind::EMPTY, tokenizer->tokenList[position]);
+        position++;
+        return empty;
+    }
+    if (position < tokenizer->tokenList.size() &&
+        Tokenization::isDatatype(tokenizer->tokenList[position].kind)) {
+        fail("expected a statement, not a declaration");
+        return none;
+    }
+
+    ChildList children;
+    parseStatement(children);
+    return children.first;
+}
+
+/*
+    This function parses an if statement and its else, if it has one.
+*/
+unsigned int AbstractSyntaxTree::parseIf() {
+    unsigned int statement = addNode(AstKind::IF, tokenizer->tokenList[position]);
+    position++;
+
+    ChildList children;
+    if (expect(TokenKind::LEFT_PARENTHESIS, "(")) {
+        addChild(children, parseExpression(orPrecedence));
+        if (expect(TokenKind::RIGHT_PARENTHESIS, ")")) {
+            addChild(children, parseBody());
+            if (check(TokenKind::KEYWORD_ELSE)) {
+                position++;
+                addChild(children, parseBody());
+            }
+        }
+    }
+    nodes[statement].firstChild = children.first;
+    return statement;
+}
+
+/*
+    This function parses a while loop.
+*/
+unsigned int AbstractSyntaxTree::parseWhile() {
+    unsigned int statement = addNode(AstKind::WHILE, tokenizer->tokenList[position]);
+    position++;
+
+    ChildList children;
+    if (expect(TokenKind::LEFT_PARENTHESIS, "(")) {
+        addChild(children, parseExpression(orPrecedence));
+        if (expect(TokenKind::RIGHT_PARENTHESIS, ")")) {
+            addChild(children, parseBody());
+        }
+    }
+    nodes[statement].firstChild = children.first;
+    return statement;
+}
+
+/*
+    This function parses a for loop. Each of the three parts in its
+    parentheses may be left out.
+*/
+unsigned int AbstractSyntaxTree::parseFor() {
+    unsigned int statement = addNode(AstKind::FOR, tokenizer->tokenList[position]);
+    position++;
+
+    ChildList children;
+    if (!expect(TokenKind::LEFT_PARENTHESIS, "(")) {
+        return statement;
+    }
+    for (int part = 0; part < 3 && !invalidSyntax; part++) {
+        TokenKind end = (part < 2) ? TokenKind::SEMICOLON : TokenKind::RIGHT_PARENTHESIS;
+        if (check(end)) {
+            addChild(children, addNode(AstKind::EMPTY, tokenizer->tokenList[position]));
+        }
+        else if (part == 1) {
+            addChild(children, parseExpression(orPrecedence));
+        }
+        else if (check(TokenKind::IDENTIFIER)) {
+            addChild(children, parseAssignmentOrCall());
+        }
+        else {
+            fail("expected an assignment");
+        }
+        expect(end, (part < 2) ? ";" : ")");
+    }
+    if (!invalidSyntax) {
+        addChild(children, parseBody());
+    }
+    nodes[statement].firstChild = children.first;
+    return statement;
+}
+
+/*
+    This function parses a return statement, with or without a value.
+*/
+unsigned int AbstractSyntaxTree::parseReturn() {
+    unsigned int statement = addNode(AstKind::RETURN, tokenizer->tokenList[position]);
+    position++;
+
+    if (!check(TokenKind::SEMICOLON)) {
+        nodes[statement].firstChild = parseExpression(orPrecedence);
+    }
+    expect(TokenKind::SEMICOLON, ";");
+    return statement;
+}
+
+/*
+    This function parses a printf statement, a format string and
+    then any number of values.
+*/
+unsigned int AbstractSyntaxTree::parsePrintf() {
+    unsigned int statement = addNode(AstKind::PRINTF, tokenizer->tokenList[position]);
+    position++;
+
+    ChildList children;
+    if (expect(TokenKind::LEFT_PARENTHESIS, "(")) {
+        if (check(TokenKind::DOUBLE_QUOTE)) {
+            addChild(children, parseLiteral(AstKind::STRING, TokenKind::DOUBLE_QUOTE));
+            while (!invalidSyntax && check(TokenKind::COMMA)) {
+                position++;
+                addChild(children, parseExpression(orPrecedence));
+            }
+            if (expect(TokenKind::RIGHT_PARENTHESIS, ")")) {
+                expect(TokenKind::SEMICOLON, ";");
+            }
+        }
+        else {
+            fail("expected the format string of printf");
+        }
+    }
+    nodes[statement].firstChild = children.first;
+    return statement;
+}
+
+/*
+    This function parses an assignment to a variable or array
+    element, or a call of a function or procedure, without the ;
+    after it.
+*/
+unsigned int AbstractSyntaxTree::parseAssignmentOrCall() {
+    const Token &name = tokenizer->tokenList[position];
+    if (position + 1 < tokenizer->tokenList.size() &&
+        tokenizer->tokenList[position + 1].kind == TokenKind::LEFT_PARENTHESIS) {
+        unsigned int statement = addNode(AstKind::CALL_STATEMENT, name);
+        nodes[statement].firstChild = parsePrimary();
+        return statement;
+    }
+
+    unsigned int statement = addNode(AstKind::ASSIGNMENT, name);
+    ChildList children;
+    addChild(children, parseTarget());
+    if (expect(TokenKind::ASSIGNMENT, "=")) {
+        addChild(children, parseExpression(orPrecedence));
+    }
+    nodes[statement].firstChild = children.first;
+    return statement;
+}
+
+/*
+    This function parses a name, or a name and an index in brackets,
+    as a VARIABLE or INDEX node.
+*/
+unsigned int AbstractSyntaxTree::parseTarget() {
+    const Token &name = tokenizer->tokenList[position];
+    position++;
+    if (!check(TokenKind::LEFT_BRACKET)) {
+        unsigned int variable = addNode(AstKind::VARIABLE, name);
+        nodes[variable].atom = name.atom;
+        return variable;
+    }
+
+    unsigned int element = addNode(AstKind::INDEX, name);
+    nodes[element].atom = name.atom;
+    position++;
+    nodes[element].firstChild = parseExpression(orPrecedence);
+    expect(TokenKind::RIGHT_BRACKET, "]");
+    return element;
+}
+
+/*
+    This function parses an expression by precedence climbing. Binary
+    operators with a precedence of at least minPrecedence are read,
+    each followed by an expression of operators that are done first.
+*/
+unsigned int AbstractSyntaxTree::parseExpression(int minPrecedence) {
+    // parentheses, signs and ^ nest expressions inside each other
+    if (depth >= maxNestingDepth) {
+        fail("expression is nested too deeply");
+        return none;
+    }
+    depth++;
+    unsigned int left = parseUnary();
+
+    while (!invalidSyntax) {
+        TokenKind op;
+        bool takesSign;
+        int precedence = binaryPrecedence(op, takesSign);
+        if (precedence == 0 || precedence < minPrecedence) {
+            break;
+        }
+
+        unsigned int binary = addNode(AstKind::BINARY, tokenizer->tokenList[position]);
+        nodes[binary].type = op;
+        if (takesSign) {
+            // the INTEGER is read again as the right operand, without its sign
+            signTaken = true;
+        }
+        else {
+            position++;
+        }
+
+        // ^ is done right to left, so it takes the same precedence again
+        int rightPrecedence = (op == TokenKind::CARET) ? precedence : precedence + 1;
+        unsigned int right = parseExpression(rightPrecedence);
+
+        nodes[binary].location = nodes[left].location;
+        nodes[binary].firstChild = left;
+        nodes[left].nextSibling = right;
+        left = binary;
+    }
+    depth--;
+    return left;
+}
+
+/*
+    This function parses a value that may have a - or ! before it.
+    The operand of - or ! is only the value and any ^ after it.
+*/
+unsigned int AbstractSyntaxTree::parseUnary() {
+    if (check(TokenKind::MINUS) || check(TokenKind::BOOLEAN_NOT)) {
+        unsigned int unary = addNode(AstKind::UNARY, tokenizer->tokenList[position]);
+        position++;
+        nodes[unary].firstChild = parseExpression(powerPrecedence);
+        return unary;
+    }
+    return parsePrimary();
+}
+
+/*
+    This function parses a value: an integer, character, string,
+    variable, array element, call, or an expression in parentheses.
+*/
+unsigned int AbstractSyntaxTree::parsePrimary() {
+    if (position >= tokenizer->tokenList.size()) {
+        fail("expected a value");
+        return none;
+    }
+
+    const Token &token = tokenizer->tokenList[position];
+    switch (token.kind) {
+        case TokenKind::INTEGER: {
+            unsigned int integer = addNode(AstKind::INTEGER, token);
+            nodes[integer].value = token.integerValue;
+            // the sign was read as an operator, so the value is the digits
+            if (signTaken) {
+                signTaken = false;
+                if (token.integerValue < 0) {
+                    nodes[integer].value = -token.integerValue;
+                }
+            }
+            position++;
+            return integer;
+        }
+        case TokenKind::SINGLE_QUOTE:
+            return parseLiteral(AstKind::CHARACTER, TokenKind::SINGLE_QUOTE);
+        case TokenKind::DOUBLE_QUOTE:
+            return parseLiteral(AstKind::STRING, TokenKind::DOUBLE_QUOTE);
+        case TokenKind::LEFT_PARENTHESIS: {
+            position++;
+            unsigned int inner = parseExpression(orPrecedence);
+            expect(TokenKind::RIGHT_PARENTHESIS, ")");
+            return inner;
+        }
+        case TokenKind::IDENTIFIER:
+            break;
+        default:
+            fail("expected a value");
+            return none;
+    }
+
+    // a name followed by ( is a call
+    if (position + 1 < tokenizer->tokenList.size() &&
+        tokenizer->tokenList[position + 1].kind == TokenKind::LEFT_PARENTHESIS) {
+        unsigned int call = addNode(AstKind::CALL, token);
+        nodes[call].atom = token.atom;
+        position += 2;
+
+        ChildList arguments;
+        if (!check(TokenKind::RIGHT_PARENTHESIS)) {
+            do {
+                addChild(arguments, parseExpression(orPrecedence));
+            } while (!invalidSyntax && check(TokenKind::COMMA) && ++position);
+        }
+        expect(TokenKind::RIGHT_PARENTHESIS, ")");
+        nodes[call].firstChild = arguments.first;
+        return call;
+    }
+    return parseTarget();
+}
+
+/*
+    This function parses a character or string in quotes. Its text is
+    the node's atom, and a character's value is the character, with
+    an escape sequence turned into the character it stands for.
+*/
+unsigned int AbstractSyntaxTree::parseLiteral(AstKind kind, TokenKind quote) {
+    unsigned int literal = addNode(kind, tokenizer->tokenList[position]);
+    position++;
+
+    std::string text;
+    if (check(TokenKind::STRING)) {
+        text = tokenizer->value(tokenizer->tokenList[position]);
+        position++;
+    }
+    nodes[literal].atom = tokenizer->atoms.intern(text);
+
+    if (kind == AstKind::CHARACTER && !text.empty()) {
+        char character = text[0];
+        if (character == '\\' && text.size() > 1) {
+            switch (text[1]) {
+                case 'n': character = '\n'; break;
+                case 't': character = '\t'; break;
+                case '0': character = '\0'; break;
+                default: character = text[1]; break;
+            }
+        }
+        nodes[literal].value = static_cast<unsigned char>(character);
+    }
+
+    expect(quote, (quote == TokenKind::SINGLE_QUOTE) ? "'" : "\"");
+    return literal;
+}
+
+/*
+    This function returns the precedence of the binary operator at
+    position and sets op to it, or returns 0 if there isn't one. The
+    tokenizer reads -1 and +1 as one INTEGER, so an INTEGER right after
+    a value is a - or + with the INTEGER's digits as the right operand.
+    takesSign is set for those.
+*/
+int AbstractSyntaxTree::binaryPrecedence(TokenKind &op, bool &takesSign) const {
+    takesSign = false;
+    if (position >= tokenizer->tokenList.size()) {
+        return 0;
+    }
+
+    const Token &token = tokenizer->tokenList[position];
+    op = token.kind;
+    switch (token.kind) {
+        case TokenKind::BOOLEAN_OR:
+            return orPrecedence;
+        case TokenKind::BOOLEAN_AND:
+            return andPrecedence;
+        case TokenKind::BOOLEAN_EQUAL:
+        case TokenKind::NOT_EQUAL:
+            return equalityPrecedence;
+        case TokenKind::LESS_THAN:
+        case TokenKind::GREATER_THAN:
+        case TokenKind::LESS_THAN_OR_EQUAL:
+        case TokenKind::GREATER_THAN_OR_EQUAL:
+            return comparisonPrecedence;
+        case TokenKind::PLUS:
+        case TokenKind::MINUS:
+            return additivePrecedence;
+        case TokenKind::ASTERISK:
+        case TokenKind::DIVIDE:
+        case TokenKind::MODULO:
+            return multiplicativePrecedence;
+        case TokenKind::CARET:
+            return powerPrecedence;
+        case TokenKind::INTEGER: {
+            // a - is kept in the value, a + is dropped just before it
+            std::size_t location = tokenizer->location(token);
+            if (tokenizer->value(token)[0] == '-') {
+                op = TokenKind::MINUS;
+            }
+            else if (location > 0 && tokenizer->source[location - 1] == '+') {
+                op = TokenKind::PLUS;
+            }
+            else {
+                return 0;
+            }
+            takesSign = true;
+            return additivePrecedence;
+        }
+        default:
+            return 0;
+    }
+}
+
+/*
+    This function returns true if the token at position is of kind.
+*/
+bool AbstractSyntaxTree::check(TokenKind kind) const {
+    return position < tokenizer->tokenList.size() && tokenizer->tokenList[position].kind == kind;
+}
+
+/*
+    This function returns true if the token at position is the name
+    word, which starts a statement but isn't a reserved word.
+*/
+bool AbstractSyntaxTree::checkWord(unsigned int word) const {
+    return check(TokenKind::IDENTIFIER) && tokenizer->tokenList[position].atom == word;
+}
+
+/*
+    This function reads a token of kind, whose text is text. A syntax
+    error is set if the token at position isn't one. Returns true if
+    the token was read.
+*/
+bool AbstractSyntaxTree::expect(TokenKind kind, const char* text) {
+    if (check(kind)) {
+        position++;
+        return true;
+    }
+    fail(std::string("expected \"") + text + "\"");
+    return false;
+}
+
+/*
+    This function sets the syntax error for the token at position,
+    unless there already is one, and stops the parse.
+*/
+void AbstractSyntaxTree::fail(const std::string &message) {
+    if (invalidSyntax) {
+        return;
+    }
+    const std::vector<Token> &tokenList = tokenizer->tokenList;
+    invalidSyntax = true;
+    if (position < tokenList.size()) {
+        errorType = message + " but found \"" + tokenizer->value(tokenList[position]) + "\".";
+        errorLineNumber = tokenizer->line(tokenList[position]);
+    }
+    else {
+        errorType = message + " but the program ended.";
+        errorLineNumber = tokenizer->line(tokenList.back());
+    }
+
+    // every loop of the parser ends at the end of the tokens
+    position = tokenList.size();
+}
+
+/*
+    This function displays the tree in format, but if there is an
+    error the syntax error will be printed in the output file instead.
+    The text has one node per line with its children indented under
+    it, while the records are the nodes in order, with the numbers of
+    the nodes they link to or -1.
+*/
+void AbstractSyntaxTree::displayAST(const std::string &outputFilename, ReportFormat format) {
+    // if there is no root, that means there was an error tokenizing
+    if (root == none) {
+        return;
+    }
+
+    ReportWriter outFile(outputFilename, format);
+
+    // error detected when parsing
+    if (invalidSyntax) {
+        if (outFile.isText()) {
+            outFile << "Syntax error on line " << errorLineNumber << ": " << errorType << '\n';
+            return;
+        }
+        outFile.beginRecord("error");
+        outFile.field("line", errorLineNumber);
+        outFile.field("message", errorType);
+        outFile.endRecord();
+        return;
+    }
+
+    if (outFile.isText()) {
+        displayNode(outFile, root, 0);
+        return;
+    }
+    for (unsigned int node = 0; node < nodes.size(); node++) {
+        displayRecord(outFile, node);
+    }
+}
+
+/*
+    This function displays a node as a record. Only the fields that
+    mean something for its kind are written.
+*/
+void AbstractSyntaxTree::displayRecord(ReportWriter &outFile, unsigned int node) const {
+    const AstNode &current = nodes[node];
+    const char* kind = kindName(current.kind);
+    outFile.beginRecord("node");
+    outFile.field("node", node);
+    outFile.field("kind", kind, std::strlen(kind));
+
+    switch (current.kind) {
+        case AstKind::FUNCTION:
+        case AstKind::PARAMETER:
+        case AstKind::DECLARATION:
+        case AstKind::UNARY:
+        case AstKind::BINARY: {
+            const char* type = operatorText(current.type);
+            outFile.field(current.kind == AstKind::UNARY || current.kind == AstKind::BINARY ?
+                          "operator" : "datatype", type, std::strlen(type));
+            break;
+        }
+        default:
+            break;
+    }
+    if (current.atom != AtomTable::none) {
+        bool isText = current.kind == AstKind::CHARACTER || current.kind == AstKind::STRING;
+        outFile.field(isText ? "text" : "name", atoms->data(current.atom), atoms->length(current.atom));
+    }
+    if (current.kind == AstKind::INTEGER || current.kind == AstKind::CHARACTER) {
+        outFile.field("value", current.value);
+    }
+    if (current.isArray) {
+        outFile.field("arraySize", current.value);
+    }
+    outFile.field("line", sourceMap->line(current.location));
+    outFile.field("firstChild", current.firstChild == none ? -1 : static_cast<long long>(current.firstChild));
+    outFile.field("nextSibling", current.nextSibling == none ? -1 : static_cast<long long>(current.nextSibling));
+    outFile.endRecord();
+}
+
+/*
+    This function displays a node and its children, and then its
+    siblings, at depth.
+*/
+void AbstractSyntaxTree::displayNode(ReportWriter &outFile, unsigned int node, int depth) const {
+    for (; node != none; node = nodes[node].nextSibling) {
+        const AstNode &current = nodes[node];
+        outFile << std::string(depth * 2, ' ') << kindName(current.kind);
+
+        switch (current.kind) {
+            case AstKind::FUNCTION:
+                outFile << " " << operatorText(current.type) << " " << atoms->name(current.atom);
+                break;
+            case AstKind::PROCEDURE:
+            case AstKind::VARIABLE:
+            case AstKind::INDEX:
+            case AstKind::CALL:
+                outFile << " " << atoms->name(current.atom);
+                break;
+            case AstKind::PARAMETER:
+            case AstKind::DECLARATION:
+                outFile << " " << operatorText(current.type) << " " << atoms->name(current.atom);
+                if (current.isArray) {
+                    outFile << "[" << current.value << "]";
+                }
+                break;
+            case AstKind::INTEGER:
+                outFile << " " << current.value;
+                break;
+            case AstKind::CHARACTER:
+                outFile << " '" << atoms->name(current.atom) << "'";
+                break;
+            case AstKind::STRING:
+                outFile << " \"" << atoms->name(current.atom) << "\"";
+                break;
+            case AstKind::UNARY:
+            case AstKind::BINARY:
+                outFile << " " << operatorText(current.type);
+                break;
+            default:
+                break;
+        }
+        outFile << '\n';
+
+        displayNode(outFile, current.firstChild, depth + 1);
+    }
+}
+
+/*
+    This function returns the name of a kind of node.
+*/
+const char* AbstractSyntaxTree::kindName(AstKind kind) {
+    static const char* const names[] = {
+        "PROGRAM", "FUNCTION", "PROCEDURE", "PARAMETER", "DECLARATION", "BLOCK",
+        "IF", "WHILE", "FOR", "RETURN", "PRINTF", "ASSIGNMENT", "CALL_STATEMENT",
+        "EMPTY", "INTEGER", "CHARACTER", "STRING", "VARIABLE", "INDEX", "CALL",
+        "UNARY", "BINARY"
+    };
+    return names[static_cast<int>(kind)];
+}
+
+/*
+    This function returns the text of an operator or datatype.
+*/
+const char* AbstractSyntaxTree::operatorText(TokenKind op) {
+    switch (op) {
+        case TokenKind::PLUS: return "+";
+        case TokenKind::MINUS: return "-";
+        case TokenKind::ASTERISK: return "*";
+        case TokenKind::DIVIDE: return "/";
+        case TokenKind::MODULO: return "%";
+        case TokenKind::CARET: return "^";
+        case TokenKind::LESS_THAN: return "<";
+        case TokenKind::GREATER_THAN: return ">";
+        case TokenKind::LESS_THAN_OR_EQUAL: return "<=";
+        case TokenKind::GREATER_THAN_OR_EQUAL: return ">=";
+        case TokenKind::BOOLEAN_AND: return "&&";
+        case TokenKind::BOOLEAN_OR: return "||";
+        case TokenKind::BOOLEAN_NOT: return "!";
+        case TokenKind::BOOLEAN_EQUAL: return "==";
+        case TokenKind::NOT_EQUAL: return "!=";
+        case TokenKind::KEYWORD_INT: return "int";
+        case TokenKind::KEYWORD_CHAR: return "char";
+        case TokenKind::KEYWORD_BOOL: return "bool";
+        case TokenKind::KEYWORD_VOID: return "void";
+        default: return "?";
+    }
+}
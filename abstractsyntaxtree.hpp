@@ -0,0 +1,168 @@
+/*
+    AbstractSyntaxTree header file
+    by: Kathy
+
+    Description: The AbstractSyntaxTree class parses the token list
+    with a recursive descent parser into a tree of declarations,
+    statements and expressions. Expressions are parsed by precedence
+    climbing. The nodes are kept one after another in a vector and
+    link to their first child and next sibling by their index in it.
+    The tree uses the tokenizer's AtomTable and SourceMap, so the
+    tokenizer has to be kept as long as the tree is.
+
+    The children of each kind of node are, in order:
+        PROGRAM         declarations, functions and procedures
+        FUNCTION        parameters, then the BLOCK of its body
+        PROCEDURE       parameters, then the BLOCK of its body
+        BLOCK           declarations and statements
+        IF              condition, then statement, else statement if any
+        WHILE           condition, statement
+        FOR             initial assignment, condition, step assignment,
+                        statement, a missing part is an EMPTY node
+        RETURN          the value, if there is one
+        PRINTF          the STRING of the format, then the values
+        ASSIGNMENT      the VARIABLE or INDEX assigned to, then the value
+        CALL_STATEMENT  the CALL
+        INDEX           the index
+        CALL            the arguments
+        UNARY           the operand
+        BINARY          the left operand, then the right one
+*/
+
+#ifndef ABSTRACT_SYNTAX_TREE_HPP
+#define ABSTRACT_SYNTAX_TREE_HPP
+
+#include <string>
+#include <vector>
+
+#include "tokenization.hpp"
+
+enum class AstKind : unsigned char {
+    PROGRAM,
+    FUNCTION,
+    PROCEDURE,
+    PARAMETER,
+    DECLARATION,
+    BLOCK,
+    IF,
+    WHILE,
+    FOR,
+    RETURN,
+    PRINTF,
+    ASSIGNMENT,
+    CALL_STATEMENT,
+    EMPTY,
+    INTEGER,
+    CHARACTER,
+    STRING,
+    VARIABLE,
+    INDEX,
+    CALL,
+    UNARY,
+    BINARY
+};
+
+struct AstNode {
+    AstKind kind;
+    // operator of a UNARY or BINARY node, datatype of a declaration,
+    // parameter or function
+    TokenKind type;
+    // true for the declaration or parameter of an array
+    bool isArray;
+    // atom of the name, or of the text of a CHARACTER or STRING
+    unsigned int atom;
+    // value of an INTEGER or CHARACTER, size of an array declaration
+    int value;
+    // offset of the node's first token in the source, see SourceMap
+    unsigned int location;
+    // indexes of the linked nodes in the tree's nodes, or none
+    unsigned int firstChild;
+    unsigned int nextSibling;
+};
+
+class AbstractSyntaxTree {
+    public:
+        // default constructor
+        AbstractSyntaxTree();
+
+        // index of a node that isn't there
+        static const unsigned int none = 0xFFFFFFFFu;
+
+        // most statements and expressions that can be inside each other
+        static const unsigned int maxNestingDepth = 1000;
+
+        // member functions
+        void createAST(Tokenization& tokenizer);
+        void displayAST(const std::string &outputFilename,
+                        ReportFormat format = ReportFormat::TEXT);
+        static const char* kindName(AstKind kind);
+        bool hasSyntaxError() const { return invalidSyntax; }
+
+        // friend class
+        friend class Interpreter;
+
+    private:
+        /*
+            The first and last nodes of a list of children that is
+            being added to.
+        */
+        struct ChildList {
+            unsigned int first;
+            unsigned int last;
+
+            ChildList() : first(none), last(none) {}
+        };
+
+        // private functions
+        unsigned int addNode(AstKind kind, const Token &token);
+        void addChild(ChildList &children, unsigned int child);
+        void parseFunction(ChildList &children);
+        void parseParameters(ChildList &children);
+        void parseDeclarations(ChildList &children, AstKind kind);
+        unsigned int parseBlock();
+        void parseStatement(ChildList &children);
+        unsigned int parseBody();
+        unsigned int parseIf();
+        unsigned int parseWhile();
+        unsigned int parseFor();
+        unsigned int parseReturn();
+        unsigned int parsePrintf();
+        unsigned int parseAssignmentOrCall();
+        unsigned int parseTarget();
+        unsigned int parseExpression(int minPrecedence);
+        unsigned int parseUnary();
+        unsigned int parsePrimary();
+        unsigned int parseLiteral(AstKind kind, TokenKind quote);
+        int binaryPrecedence(TokenKind &op, bool &takesSign) const;
+        bool check(TokenKind kind) const;
+        bool checkWord(unsigned int word) const;
+        bool expect(TokenKind kind, const char* text);
+        void fail(const std::string &message);
+        void displayNode(ReportWriter &outFile, unsigned int node, int depth) const;
+        void displayRecord(ReportWriter &outFile, unsigned int node) const;
+        static const char* operatorText(TokenKind op);
+
+        std::vector<AstNode> nodes;
+        unsigned int root;
+        // the tokens being parsed and the next one to read
+        Tokenization* tokenizer;
+        std::size_t position;
+        // true if the sign of the INTEGER at position was read as
+        // a + or - operator, see binaryPrecedence
+        bool signTaken;
+        // statements and expressions being parsed inside each other
+        unsigned int depth;
+        // words that start statements but aren't reserved
+        unsigned int whileWord;
+        unsigned int forWord;
+        unsigned int returnWord;
+        // names of the nodes, owned by the tokenizer
+        const AtomTable* atoms;
+        // lines of the source, owned by the tokenizer
+        const SourceMap* sourceMap;
+        bool invalidSyntax;
+        int errorLineNumber;
+        std::string errorType;
+};
+
+#endif
@@ -0,0 +1,92 @@
+/*
+    Implementation of the AtomTable class
+    by: Kathy
+
+    Description: This file contains the implementation of the
+    AtomTable class functions declared in the header file.
+*/
+
+#include <cstring>
+
+#include "atomtable.hpp"
+
+const unsigned int AtomTable::none;
+
+/*
+    The default constructor starts with an empty table of 64 slots.
+*/
+AtomTable::AtomTable() : offsets(1, 0), slots(64, 0) {
+}
+
+/*
+    This function returns the atom of a name, adding the name to the
+    table if it hasn't been seen before. Slots are probed one after
+    another from the name's hash.
+*/
+unsigned int AtomTable::intern(const char* name, std::size_t nameLength) {
+    unsigned int nameHash = hash(name, nameLength);
+    std::size_t mask = slots.size() - 1;
+
+    for (std::size_t slot = nameHash & mask; ; slot = (slot + 1) & mask) {
+        unsigned int entry = slots[slot];
+
+        // name isn't in the table yet
+        if (entry == 0) {
+            unsigned int atom = offsets.size() - 1;
+            text.append(name, nameLength);
+            offsets.push_back(text.size());
+            hashes.push_back(nameHash);
+            slots[slot] = atom + 1;
+
+            // keep the table at most half full
+            if (size() * 2 > slots.size()) {
+                grow();
+            }
+            return atom;
+        }
+
+        unsigned int atom = entry - 1;
+        if (hashes[atom] == nameHash && length(atom) == nameLength &&
+            std::memcmp(data(atom), name, nameLength) == 0) {
+            return atom;
+        }
+    }
+}
+
+/*
+    This function returns the name of an atom.
+*/
+std::string AtomTable::name(unsigned int atom) const {
+    return std::string(data(atom), length(atom));
+}
+
+/*
+    This function returns the FNV-1a hash of a name.
+*/
+unsigned int AtomTable::hash(const char* name, std::size_t nameLength) {
+    unsigned int result = 2166136261u;
+    for (std::size_t i = 0; i < nameLength; i++) {
+        result ^= static_cast<unsigned char>(name[i]);
+        result *= 16777619u;
+    }
+    return result;
+}
+
+/*
+    This function doubles the number of slots and puts every atom
+    back in the table using the hashes that were kept.
+*/
+void AtomTable::grow() {
+    std::vector<unsigned int> newSlots(slots.size() * 2, 0);
+    std::size_t mask = newSlots.size() - 1;
+
+    for (unsigned int atom = 0; atom < size(); atom++) {
+        std::size_t slot = hashes[atom] & mask;
+        while (newSlots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        newSlots[slot] = atom + 1;
+    }
+
+    slots.swap(newSlots);
+}
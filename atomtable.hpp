@@ -0,0 +1,50 @@
+/*
+    AtomTable header file
+    by: Kathy
+
+    Description: The AtomTable class interns names. Each distinct
+    name is stored once and is given a small integer, its atom, so
+    two names are equal exactly when their atoms are equal.
+*/
+
+#ifndef ATOM_TABLE_HPP
+#define ATOM_TABLE_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class AtomTable {
+    public:
+        // default constructor
+        AtomTable();
+
+        // member functions
+        unsigned int intern(const char* name, std::size_t nameLength);
+        unsigned int intern(const std::string &name) { return intern(name.data(), name.size()); }
+        std::string name(unsigned int atom) const;
+        const char* data(unsigned int atom) const { return text.data() + offsets[atom]; }
+        std::size_t length(unsigned int atom) const { return offsets[atom + 1] - offsets[atom]; }
+        std::size_t size() const { return offsets.size() - 1; }
+
+        // atom of something that has no name
+        static const unsigned int none = 0xFFFFFFFFu;
+
+        // declare friend classes
+        friend class TokenCache;
+        friend class ConcreteSyntaxTree;
+
+    private:
+        static unsigned int hash(const char* name, std::size_t nameLength);
+        void grow();
+
+        // the names one after another
+        std::string text;
+        // offset in text of each atom's name, and the end of the last one
+        std::vector<unsigned int> offsets;
+        std::vector<unsigned int> hashes;
+        // atom + 1 in each used slot of the hash table, 0 in empty slots
+        std::vector<unsigned int> slots;
+};
+
+#endif
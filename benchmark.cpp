@@ -0,0 +1,111 @@
+/*
+    Benchmark file
+    by: Kathy
+
+    Description: This file contains a main function that measures how
+    many tokens per second the tokenizer produces for an input file,
+    with comments removed first, skipped while tokenizing (on one
+    thread and on all of the cores), and with the file streamed in
+    chunks. It also measures how long it takes to update the tokens
+    after a small edit.
+*/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "sourcebuffer.hpp"
+#include "removecomments.hpp"
+#include "tokenization.hpp"
+
+/*
+    This function prints the tokens per second for one way of
+    tokenizing, given the number of tokens found and the time taken.
+*/
+static void report(const std::string &name, std::size_t tokenCount, double seconds) {
+    std::cout << name << ": " << tokenCount << " tokens in " << seconds << " s, "
+              << static_cast<long long>(tokenCount / seconds) << " tokens/sec" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <filename> [repetitions]\n";
+        return 1;
+    }
+
+    std::string inputFile = argv[1];
+    int repetitions = (argc > 2) ? std::atoi(argv[2]) : 5;
+    if (repetitions < 1) {
+        repetitions = 1;
+    }
+
+    SourceBuffer source;
+    if (!source.open(inputFile)) {
+        std::cout << "Error: Unable to open input file." << std::endl;
+        return 1;
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    std::size_t tokenCount = 0;
+
+    // remove comments first, then tokenize the copy
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < repetitions; i++) {
+        std::string strippedSource;
+        RemoveComments::removeComments(source.begin(), source.end(), strippedSource);
+        Tokenization tokenizer;
+        tokenizer.tokenizeSource(strippedSource);
+        tokenCount += tokenizer.tokenCount();
+    }
+    report("two pass", tokenCount, std::chrono::duration<double>(Clock::now() - start).count());
+
+    // skip comments while tokenizing
+    tokenCount = 0;
+    start = Clock::now();
+    for (int i = 0; i < repetitions; i++) {
+        Tokenization tokenizer;
+        tokenizer.tokenizeSkippingComments(source.begin(), source.end());
+        tokenCount += tokenizer.tokenCount();
+    }
+    report("single pass", tokenCount, std::chrono::duration<double>(Clock::now() - start).count());
+
+    // skip comments while tokenizing, on all of the cores
+    tokenCount = 0;
+    start = Clock::now();
+    for (int i = 0; i < repetitions; i++) {
+        Tokenization tokenizer;
+        tokenizer.tokenizeParallel(source.begin(), source.end(), true);
+        tokenCount += tokenizer.tokenCount();
+    }
+    report("parallel", tokenCount, std::chrono::duration<double>(Clock::now() - start).count());
+
+    // stream the file in chunks without storing the tokens
+    tokenCount = 0;
+    start = Clock::now();
+    for (int i = 0; i < repetitions; i++) {
+        Tokenization tokenizer;
+        tokenizer.tokenizeStream(inputFile, [&tokenCount](const Token&, const std::string&) {
+            tokenCount++;
+        });
+    }
+    report("streaming", tokenCount, std::chrono::duration<double>(Clock::now() - start).count());
+
+    // insert and remove a space at spread out places
+    std::string editedSource(source.begin(), source.end());
+    Tokenization tokenizer;
+    tokenizer.tokenizeSkippingComments(editedSource.data(),
+                                       editedSource.data() + editedSource.size());
+    int editCount = repetitions * 100;
+    std::size_t place = 0;
+    start = Clock::now();
+    for (int i = 0; i < editCount; i++) {
+        place = (place * 1103515245u + 12345u) % (editedSource.size() + 1);
+        tokenizer.edit(editedSource, place, 0, " ");
+        tokenizer.edit(editedSource, place, 1, "");
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "editing: " << editCount * 2 << " edits in " << seconds << " s, "
+              << seconds * 1e6 / (editCount * 2) << " us/edit" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+/*
+    BinarySections header file
+    by: Kathy
+
+    Description: The BinarySections class contains functions for
+    files that are a fixed header followed by sections of raw arrays,
+    each one starting at a multiple of 8 bytes. The header holds the
+    size of each section. A file is written to a string and read back
+    from a mapped copy of it, one whole section at a time.
+*/
+
+#ifndef BINARY_SECTIONS_HPP
+#define BINARY_SECTIONS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class BinarySections {
+    public:
+        // member functions
+        static std::size_t padded(std::size_t size) {
+            return (size + 7) & ~static_cast<std::size_t>(7);
+        }
+        template <typename Element>
+        static void append(std::string &file, std::uint64_t &size,
+                           const Element* data, std::size_t count);
+        template <typename Vector>
+        static bool read(const char* section, std::uint64_t size, Vector &out);
+        static bool locate(const char* file, std::size_t fileSize, std::size_t headerSize,
+                           const std::uint64_t* sizes, int count, const char** sections);
+};
+
+/*
+    This function appends count elements at data to a file as one
+    section, and sets size to its size in bytes.
+*/
+template <typename Element>
+void BinarySections::append(std::string &file, std::uint64_t &size,
+                            const Element* data, std::size_t count) {
+    size = count * sizeof(Element);
+    file.append(reinterpret_cast<const char*>(data), count * sizeof(Element));
+    file.resize(padded(file.size()), '\0');
+}
+
+/*
+    This function copies a section of a mapped file into a vector.
+    Returns false if the section isn't a whole number of elements.
+*/
+template <typename Vector>
+bool BinarySections::read(const char* section, std::uint64_t size, Vector &out) {
+    typedef typename Vector::value_type Element;
+    if (size % sizeof(Element) != 0) {
+        return false;
+    }
+    const Element* first = reinterpret_cast<const Element*>(section);
+    out.assign(first, first + size / sizeof(Element));
+    return true;
+}
+
+/*
+    This function finds where each of the count sections of a file
+    starts, from their sizes, and puts it in sections. Returns false
+    if the sections don't fill the file after the header exactly.
+*/
+inline bool BinarySections::locate(const char* file, std::size_t fileSize, std::size_t headerSize,
+                                   const std::uint64_t* sizes, int count, const char** sections) {
+    std::size_t payloadSize = 0;
+    for (int section = 0; section < count; section++) {
+        if (sizes[section] > fileSize) {
+            return false;
+        }
+        sections[section] = file + headerSize + payloadSize;
+        payloadSize += padded(sizes[section]);
+    }
+    return headerSize + payloadSize == fileSize;
+}
+
+#endif
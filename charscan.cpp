@@ -0,0 +1,309 @@
+/*
+    Implementation of the CharScan class
+    by: Kathy
+
+    Description: This file contains the implementation of the
+    CharScan class functions declared in the header file.
+*/
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "charscan.hpp"
+
+/*
+    The vector versions are only built where SSE2 is available.
+*/
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#define CHAR_SCAN_X86 1
+#endif
+
+typedef const char* (*FindAnyFunction)(const char*, const char*, char, char, char, char);
+typedef std::size_t (*FindAllFunction)(const char*, const char*, const char*, char,
+                                       std::vector<unsigned int>*);
+
+/*
+    This function returns a pointer to the first of the four characters
+    found between current and end, checking one byte at a time. end is
+    returned if none of them are found.
+*/
+static const char* findAnyScalar(const char* current, const char* end,
+                                 char first, char second, char third, char fourth) {
+    while (current != end) {
+        char currentChar = *current;
+        if (currentChar == first || currentChar == second ||
+            currentChar == third || currentChar == fourth) {
+            return current;
+        }
+        current++;
+    }
+    return end;
+}
+
+/*
+    This function counts the target characters from current to end,
+    and adds their offsets from begin to offsets unless it is null.
+*/
+static std::size_t findAllScalar(const char* begin, const char* current, const char* end,
+                                 char target, std::vector<unsigned int>* offsets) {
+    std::size_t found = 0;
+    for (; current != end; current++) {
+        if (*current == target) {
+            if (offsets) {
+                offsets->push_back(static_cast<unsigned int>(current - begin));
+            }
+            found++;
+        }
+    }
+    return found;
+}
+
+#ifdef CHAR_SCAN_X86
+/*
+    This function adds the offsets of the bits set in mask, which are
+    the matches in the block at current, and returns how many there are.
+*/
+static inline std::size_t addMatches(const char* begin, const char* current, unsigned int mask,
+                                     std::vector<unsigned int>* offsets) {
+    if (offsets) {
+        unsigned int blockOffset = static_cast<unsigned int>(current - begin);
+        for (unsigned int bits = mask; bits != 0; bits &= bits - 1) {
+            offsets->push_back(blockOffset + __builtin_ctz(bits));
+        }
+    }
+    return __builtin_popcount(mask);
+}
+
+/*
+    This function does the same search as findAnyScalar, 16 bytes
+    at a time.
+*/
+static const char* findAnySSE2(const char* current, const char* end,
+                               char first, char second, char third, char fourth) {
+    const __m128i firstVector = _mm_set1_epi8(first);
+    const __m128i secondVector = _mm_set1_epi8(second);
+    const __m128i thirdVector = _mm_set1_epi8(third);
+    const __m128i fourthVector = _mm_set1_epi8(fourth);
+
+    while (end - current >= 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+        __m128i matches = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, firstVector), _mm_cmpeq_epi8(block, secondVector)),
+            _mm_or_si128(_mm_cmpeq_epi8(block, thirdVector), _mm_cmpeq_epi8(block, fourthVector)));
+        int mask = _mm_movemask_epi8(matches);
+        if (mask != 0) {
+            return current + __builtin_ctz(mask);
+        }
+        current += 16;
+    }
+    return findAnyScalar(current, end, first, second, third, fourth);
+}
+
+/*
+    This function does the same search as findAnyScalar, 32 bytes
+    at a time. It is only called when the CPU supports AVX2.
+*/
+__attribute__((target("avx2")))
+static const char* findAnyAVX2(const char* current, const char* end,
+                               char first, char second, char third, char fourth) {
+    const __m256i firstVector = _mm256_set1_epi8(first);
+    const __m256i secondVector = _mm256_set1_epi8(second);
+    const __m256i thirdVector = _mm256_set1_epi8(third);
+    const __m256i fourthVector = _mm256_set1_epi8(fourth);
+
+    while (end - current >= 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current));
+        __m256i matches = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, firstVector), _mm256_cmpeq_epi8(block, secondVector)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, thirdVector), _mm256_cmpeq_epi8(block, fourthVector)));
+        unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(matches));
+        if (mask != 0) {
+            return current + __builtin_ctz(mask);
+        }
+        current += 32;
+    }
+    // clear the upper halves first, SSE code after AVX code is slow otherwise
+    _mm256_zeroupper();
+    return findAnySSE2(current, end, first, second, third, fourth);
+}
+
+/*
+    This function does the same as findAllScalar, 16 bytes at a time.
+*/
+static std::size_t findAllSSE2(const char* begin, const char* current, const char* end,
+                               char target, std::vector<unsigned int>* offsets) {
+    const __m128i targetVector = _mm_set1_epi8(target);
+    std::size_t found = 0;
+
+    while (end - current >= 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+        unsigned int mask = static_cast<unsigned int>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(block, targetVector)));
+        if (mask != 0) {
+            found += addMatches(begin, current, mask, offsets);
+        }
+        current += 16;
+    }
+    return found + findAllScalar(begin, current, end, target, offsets);
+}
+
+/*
+    This function does the same as findAllScalar, 32 bytes at a time.
+    It is only called when the CPU supports AVX2.
+*/
+__attribute__((target("avx2")))
+static std::size_t findAllAVX2(const char* begin, const char* current, const char* end,
+                               char target, std::vector<unsigned int>* offsets) {
+    const __m256i targetVector = _mm256_set1_epi8(target);
+    std::size_t found = 0;
+
+    while (end - current >= 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current));
+        unsigned int mask = static_cast<unsigned int>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, targetVector)));
+        if (mask != 0) {
+            found += addMatches(begin, current, mask, offsets);
+        }
+        current += 32;
+    }
+    _mm256_zeroupper();
+    return found + findAllSSE2(begin, current, end, target, offsets);
+}
+#endif
+
+/*
+    This function picks the fastest version of findAny for this CPU.
+*/
+static FindAnyFunction bestFindAny() {
+#ifdef CHAR_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return findAnyAVX2;
+    }
+    return findAnySSE2;
+#else
+    return findAnyScalar;
+#endif
+}
+
+/*
+    This function picks the fastest version of findAll for this CPU.
+*/
+static FindAllFunction bestFindAll() {
+#ifdef CHAR_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return findAllAVX2;
+    }
+    return findAllSSE2;
+#else
+    return findAllScalar;
+#endif
+}
+
+/*
+    The version of findAny in use, changed by setVectorized and
+    setLevel.
+*/
+static FindAnyFunction& findAnyFunction() {
+    static FindAnyFunction function = bestFindAny();
+    return function;
+}
+
+/*
+    The version of findAll in use, changed by setVectorized and
+    setLevel.
+*/
+static FindAllFunction& findAllFunction() {
+    static FindAllFunction function = bestFindAll();
+    return function;
+}
+
+/*
+    This function returns a pointer to the first occurrence of any of
+    the four characters between current and end, or end if there is
+    none. Pass the same character more than once to search for fewer.
+*/
+const char* CharScan::findAny(const char* current, const char* end,
+                              char first, char second, char third, char fourth) {
+    return findAnyFunction()(current, end, first, second, third, fourth);
+}
+
+/*
+    This function adds the offsets from begin of every target character
+    between begin and end to offsets, and returns how many there are.
+*/
+std::size_t CharScan::findAll(const char* begin, const char* end, char target,
+                              std::vector<unsigned int> &offsets) {
+    return findAllFunction()(begin, begin, end, target, &offsets);
+}
+
+/*
+    This function returns how many target characters there are
+    between begin and end.
+*/
+std::size_t CharScan::count(const char* begin, const char* end, char target) {
+    return findAllFunction()(begin, begin, end, target, nullptr);
+}
+
+/*
+    This function turns the vector versions on or off. Turning them
+    off is useful to check that both versions give the same results.
+*/
+void CharScan::setVectorized(bool enabled) {
+    findAnyFunction() = enabled ? bestFindAny() : findAnyScalar;
+    findAllFunction() = enabled ? bestFindAll() : findAllScalar;
+}
+
+/*
+    This function returns true if a vector version is in use.
+*/
+bool CharScan::isVectorized() {
+    return findAnyFunction() != findAnyScalar;
+}
+
+/*
+    This function picks one version, so each can be checked against
+    the others. Returns false, and keeps the version in use, if this
+    CPU or build doesn't have it.
+*/
+bool CharScan::setLevel(ScanLevel level) {
+    switch (level) {
+        case ScanLevel::SCALAR:
+            findAnyFunction() = findAnyScalar;
+            findAllFunction() = findAllScalar;
+            return true;
+#ifdef CHAR_SCAN_X86
+        case ScanLevel::SSE2:
+            findAnyFunction() = findAnySSE2;
+            findAllFunction() = findAllSSE2;
+            return true;
+        case ScanLevel::AVX2:
+            __builtin_cpu_init();
+            if (!__builtin_cpu_supports("avx2")) {
+                return false;
+            }
+            findAnyFunction() = findAnyAVX2;
+            findAllFunction() = findAllAVX2;
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+/*
+    This function returns the version in use.
+*/
+ScanLevel CharScan::level() {
+#ifdef CHAR_SCAN_X86
+    if (findAnyFunction() == findAnyAVX2) {
+        return ScanLevel::AVX2;
+    }
+    if (findAnyFunction() == findAnySSE2) {
+        return ScanLevel::SSE2;
+    }
+#endif
+    return ScanLevel::SCALAR;
+}
@@ -0,0 +1,40 @@
+/*
+    CharScan header file
+    by: Kathy
+
+    Description: The CharScan class contains functions that search
+    a range of characters many bytes at a time. SSE2 is used on x86
+    and AVX2 is used when the CPU supports it, otherwise a plain
+    loop is used.
+*/
+
+#ifndef CHAR_SCAN_HPP
+#define CHAR_SCAN_HPP
+
+#include <cstddef>
+#include <vector>
+
+/*
+    The versions of CharScan, from the plain loop to the widest vectors.
+*/
+enum class ScanLevel : unsigned char {
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+class CharScan {
+    public:
+        // member functions
+        static const char* findAny(const char* current, const char* end,
+                                   char first, char second, char third, char fourth);
+        static std::size_t findAll(const char* begin, const char* end, char target,
+                                   std::vector<unsigned int> &offsets);
+        static std::size_t count(const char* begin, const char* end, char target);
+        static void setVectorized(bool enabled);
+        static bool isVectorized();
+        static bool setLevel(ScanLevel level);
+        static ScanLevel level();
+};
+
+#endif
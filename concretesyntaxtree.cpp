@@ -7,167 +7,408 @@
     header file.
 */
 
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <type_traits>
 
 #include "concretesyntaxtree.hpp"
+#include "binarysections.hpp"
+#include "sourcebuffer.hpp"
+#include "tokencache.hpp"
+
+const unsigned int ConcreteSyntaxTree::none;
+
+namespace {
+
+const char treeMagic[8] = {'C', 'S', 'T', 'R', 'E', 'E', '\0', '\0'};
+// has to change whenever the format or the numbering of TokenKind does
+const std::uint32_t treeFormatVersion = 1;
+
+/*
+    The sections of a saved tree, in the order they are written.
+*/
+enum TreeSection {
+    KINDS,
+    VALUE_ATOMS,
+    INTEGER_VALUES,
+    LOCATIONS,
+    LEFT_CHILDREN,
+    RIGHT_SIBLINGS,
+    ATOM_TEXT,
+    ATOM_OFFSETS,
+    ATOM_HASHES,
+    ATOM_SLOTS,
+    NEWLINES,
+    SKIPPED_NEWLINES,
+    ERROR_TYPE,
+    TREE_SECTION_COUNT
+};
+
+/*
+    The header at the start of a saved tree.
+*/
+struct TreeHeader {
+    char magic[8];
+    std::uint32_t formatVersion;
+    std::uint32_t nodeCount;
+    std::uint32_t root;
+    std::int32_t errorLineNumber;
+    std::uint8_t invalidSyntax;
+    std::uint8_t unused[7];
+    // hash of the header, with this set to 0, and then the sections
+    std::uint64_t contentHash;
+    std::uint64_t sectionSizes[TREE_SECTION_COUNT];
+};
+
+static_assert(sizeof(TreeHeader) % 8 == 0, "sections start at a multiple of 8 bytes");
+static_assert(std::is_same<std::underlying_type<TokenKind>::type, unsigned char>::value,
+              "kinds are saved one byte each");
+
+/*
+    This function returns true if every link is a node number below
+    nodeCount or none.
+*/
+bool linksAreValid(const std::vector<unsigned int> &links, unsigned int nodeCount) {
+    for (std::size_t i = 0; i < links.size(); i++) {
+        if (links[i] >= nodeCount && links[i] != ConcreteSyntaxTree::none) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
 
 /*
     This is the default constructor for the ConcreteSyntaxTree class.
-    The root node and current node are initialized to nullptr.
+    The root node and current node are initialized to none.
 */
 ConcreteSyntaxTree::ConcreteSyntaxTree() {
-    root = nullptr;
-    currentNode = nullptr;
-    invalidSyntax = false;
-    errorLineNumber = 0;
+    root = none;
+    currentNode = none;
+    atoms = nullptr;
+    sourceMap = nullptr;
+    resetChecks();
 }
 
 /*
     This function creates the concrete syntax tree from the token list
-    utilizing left child and right sibling relationships.
+    utilizing left child and right sibling relationships. The tree is
+    checked for errors as it is created. If failFast is true, no more
+    nodes are added after the first error.
 */
-void ConcreteSyntaxTree::createCST(Tokenization& tokenizer) {
+void ConcreteSyntaxTree::createCST(Tokenization& tokenizer, bool failFast) {
     // if there were errors while tokenizing, return
     if (tokenizer.invalidToken) {
         return;
     }
 
     bool nextIsChild = false;
+    atoms = &tokenizer.atoms;
+    sourceMap = &tokenizer.sourceMap;
+    resetChecks();
 
-    // create cst
+    // create cst, one node per token
+    reserveNodes(tokenizer.tokenList.size());
     for (int i = 0; i < tokenizer.tokenList.size(); i++) {
-        // create a tree node for current token
-        TreeNode* newNode = new TreeNode(tokenizer.tokenList.at(i).value, 
-                                         tokenizer.tokenList.at(i).lineNumber);
-        
-        // set root of tree
-        if (i == 0) {
-            root = newNode;
-            currentNode = root;
+        addNode(tokenizer, tokenizer.tokenList.at(i), nextIsChild);
+        if (failFast && invalidSyntax) {
+            break;
         }
-        
-        // figure out of token is going to be a child or sibling
-        if (nextIsChild) {
-            // current token is a child because of previous token
-            currentNode->leftChild = newNode;
-            currentNode = newNode;
+    }
+
+    if (root == none) {
+        std::cout << "Error: there is no root." << std::endl;
+    }
+}
+
+/*
+    This function creates the concrete syntax tree from tokens that
+    are read from tokens as they are needed, so the token list is
+    never built. If an invalid token is found, no tree is kept, the
+    same as if the token list had been built first. If failFast is
+    true, the source isn't read past the first error in the tree, so
+    an invalid token after it isn't found.
+*/
+void ConcreteSyntaxTree::createCST(TokenStream& tokens, bool failFast) {
+    Tokenization& tokenizer = tokens.tokenizer;
+    bool nextIsChild = false;
+    atoms = &tokenizer.atoms;
+    sourceMap = &tokenizer.sourceMap;
+    resetChecks();
 
-            // reset nextIsChild
-            nextIsChild = false;
+    // create cst
+    Token token;
+    while (tokens.next(token)) {
+        addNode(tokenizer, token, nextIsChild);
+        if (failFast && invalidSyntax) {
+            return;
         }
-        else {
-            if (newNode->token == "{" || newNode->token == "}") {
-                // these tokens are always going to be left children
-                currentNode->leftChild = newNode;
-                currentNode = newNode;
-            }
-            else {
-                // otherwise the token will always be right sibling
-                currentNode->rightSibling = newNode;
-                currentNode = newNode;
-            }
+    }
+    tokens.finish();
+
+    // if there were errors while tokenizing, throw away the tree
+    if (tokenizer.invalidToken) {
+        deleteTree();
+        return;
+    }
+
+    if (root == none) {
+        std::cout << "Error: there is no root." << std::endl;
+    }
+}
+
+/*
+    This function adds a tree node for a token as the left child or
+    right sibling of the current node. nextIsChild is true if the
+    node has to be a child because of the token before it.
+*/
+void ConcreteSyntaxTree::addNode(Tokenization& tokenizer, const Token& token, bool& nextIsChild) {
+    // identifiers already have an atom, other values are interned here
+    unsigned int atom = token.atom;
+    if (atom == AtomTable::none) {
+        atom = tokenizer.atoms.intern(tokenizer.value(token));
+    }
+    unsigned int newNode = static_cast<unsigned int>(kinds.size());
+    kinds.push_back(token.kind);
+    valueAtoms.push_back(atom);
+    integerValues.push_back(token.integerValue);
+    locations.push_back(static_cast<unsigned int>(tokenizer.location(token)));
+    leftChildren.push_back(none);
+    rightSiblings.push_back(none);
+
+    // set root of tree, which isn't linked to anything
+    bool isSibling = true;
+    if (root == none) {
+        root = newNode;
+        currentNode = root;
+        isSibling = false;
+    }
+    // figure out of token is going to be a child or sibling
+    else if (nextIsChild) {
+        // current token is a child because of previous token
+        leftChildren[currentNode] = newNode;
+        currentNode = newNode;
+
+        // reset nextIsChild
+        nextIsChild = false;
+        isSibling = false;
+    }
+    else {
+        if (token.kind == TokenKind::LEFT_BRACE || token.kind == TokenKind::RIGHT_BRACE) {
+            // these tokens are always going to be left children
+            leftChildren[currentNode] = newNode;
+            currentNode = newNode;
+            isSibling = false;
         }
-        
-        // next token is always a child if we encounter {, }, or ;
-        if (currentNode->token == "{" || currentNode->token == "}" || currentNode->token == ";") {
-            nextIsChild = true;
+        else {
+            // otherwise the token will always be right sibling
+            rightSiblings[currentNode] = newNode;
+            currentNode = newNode;
         }
     }
+    
+    // next token is always a child if we encounter {, }, or ;
+    if (token.kind == TokenKind::LEFT_BRACE || token.kind == TokenKind::RIGHT_BRACE ||
+        token.kind == TokenKind::SEMICOLON) {
+        nextIsChild = true;
+    }
 
-    // check for errors in the CST
-    errorCheckCST();
+    // check for errors that the new node makes, most nodes neither
+    // start a check nor are checked
+    if (pendingCheck != PendingCheck::NONE || token.kind == TokenKind::LEFT_BRACKET ||
+        token.kind == TokenKind::KEYWORD_INT || token.kind == TokenKind::KEYWORD_CHAR ||
+        token.kind == TokenKind::KEYWORD_BOOL || token.kind == TokenKind::KEYWORD_FUNCTION) {
+        checkNode(newNode, isSibling);
+    }
 }
 
 /*
-    This function checks for syntax errors that might exist
-    in the CST.
+    This function makes room for count more nodes.
 */
-void ConcreteSyntaxTree::errorCheckCST() {
-    if (!root) {
-        std::cout << "Error: there is no root." << std::endl;
+void ConcreteSyntaxTree::reserveNodes(std::size_t count) {
+    std::size_t size = kinds.size() + count;
+    kinds.reserve(size);
+    valueAtoms.reserve(size);
+    integerValues.reserve(size);
+    locations.reserve(size);
+    leftChildren.reserve(size);
+    rightSiblings.reserve(size);
+}
+
+/*
+    This function deletes every node of the tree, all at once since
+    they are kept together.
+*/
+void ConcreteSyntaxTree::deleteTree() {
+    std::vector<TokenKind>().swap(kinds);
+    std::vector<unsigned int>().swap(valueAtoms);
+    std::vector<int>().swap(integerValues);
+    std::vector<unsigned int>().swap(locations);
+    std::vector<unsigned int>().swap(leftChildren);
+    std::vector<unsigned int>().swap(rightSiblings);
+    root = none;
+    currentNode = none;
+    resetChecks();
+}
+
+/*
+    This function clears the errors and the state of the checks,
+    before a tree is created.
+*/
+void ConcreteSyntaxTree::resetChecks() {
+    pendingCheck = PendingCheck::NONE;
+    checksDone = false;
+    invalidSyntax = false;
+    errorLineNumber = 0;
+    errorType.clear();
+}
+
+/*
+    This function checks for syntax errors that a node makes with the
+    nodes before it, as it is added. A [ is followed by an array size
+    that can't be negative, a datatype by a variable name and function
+    by a datatype and a function name that can't be reserved words.
+    The node that is checked is the right sibling of the one before
+    it, so a node that is a left child ends the check without an
+    error. An array size or variable name error ends the checks, while
+    a later error replaces a function name error.
+*/
+void ConcreteSyntaxTree::checkNode(unsigned int node, bool isSibling) {
+    if (checksDone) {
         return;
     }
-    
-    currentNode = root;
 
-    while (currentNode->leftChild || currentNode->rightSibling) {
-        // check array declaration size is positive integer
-        if (currentNode->token == "[") {
-            // check next sibling is not a negative integer
-            currentNode = currentNode->rightSibling;
-            if (currentNode->token[0] == '-') {
+    TokenKind kind = kinds[node];
+    PendingCheck check = isSibling ? pendingCheck : PendingCheck::NONE;
+    pendingCheck = PendingCheck::NONE;
+
+    switch (check) {
+        case PendingCheck::ARRAY_SIZE:
+            // check array declaration size is positive integer
+            if (atoms->data(valueAtoms[node])[0] == '-') {
                 // set errors
                 invalidSyntax = true;
+                checksDone = true;
                 errorType = "array declaration size must be a positive integer.";
-                errorLineNumber = currentNode->lineNumber;
+                errorLineNumber = sourceMap->line(locations[node]);
                 return;
             }
-        }
 
-        // check variable declarations are not reserved words
-        if (currentNode->token == "char" || currentNode->token == "int" ||
-            currentNode->token == "bool") {
+            // a datatype or function after the [ is checked as well
+            if (Tokenization::isDatatype(kind)) {
+                pendingCheck = PendingCheck::VARIABLE_NAME;
+            }
+            else if (kind == TokenKind::KEYWORD_FUNCTION) {
+                pendingCheck = PendingCheck::FUNCTION_DATATYPE;
+            }
+            return;
 
-            // checking next sibling is not a reserved word
-            currentNode = currentNode->rightSibling;
-            if (currentNode->token == "char" || currentNode->token == "int" ||
-                currentNode->token == "bool" || currentNode->token == "void" ||
-                currentNode->token == "if"   || currentNode->token == "else" || 
-                currentNode->token == "function" || currentNode->token == "printf") {
+        case PendingCheck::VARIABLE_NAME:
+            // check variable declarations are not reserved words
+            if (isReservedName(kind)) {
                 // set errors
                 invalidSyntax = true;
-                errorType = "reserved word \"" + currentNode->token + 
+                checksDone = true;
+                errorType = "reserved word \"" + atoms->name(valueAtoms[node]) +
                             "\" cannot be used for the name of a variable.";
-                errorLineNumber = currentNode->lineNumber;
-                return;
+                errorLineNumber = sourceMap->line(locations[node]);
             }
-        }
+            return;
+
+        case PendingCheck::FUNCTION_DATATYPE:
+            pendingCheck = PendingCheck::FUNCTION_NAME;
+            return;
 
-        // check function names are not reserved words
-        if (currentNode->token == "function") {
-            // move two siblings over
-            currentNode = currentNode->rightSibling;
-            currentNode = currentNode->rightSibling;
-
-            // check it is not using reserved word
-            if (currentNode->token == "char" || currentNode->token == "int" ||
-                currentNode->token == "bool" || currentNode->token == "void" ||
-                currentNode->token == "if"   || currentNode->token == "else" || 
-                currentNode->token == "function" || currentNode->token == "printf") {
+        case PendingCheck::FUNCTION_NAME:
+            // check function names are not reserved words
+            if (isReservedName(kind)) {
                 // set errors
                 invalidSyntax = true;
-                errorType = "reserved word \"" + currentNode->token +
+                errorType = "reserved word \"" + atoms->name(valueAtoms[node]) +
                             "\" cannot be used for the name of a function.";
-                errorLineNumber = currentNode->lineNumber;
+                errorLineNumber = sourceMap->line(locations[node]);
             }
-        }
+            return;
 
-        // move current node to next node
-        if (currentNode->rightSibling) {
-            currentNode = currentNode->rightSibling;
-        }
-        else if (currentNode->leftChild) {
-            currentNode = currentNode->leftChild;
-        }
+        case PendingCheck::NONE:
+            break;
+    }
+
+    // this node starts a check of the nodes after it
+    if (kind == TokenKind::LEFT_BRACKET) {
+        pendingCheck = PendingCheck::ARRAY_SIZE;
+    }
+    else if (Tokenization::isDatatype(kind)) {
+        pendingCheck = PendingCheck::VARIABLE_NAME;
+    }
+    else if (kind == TokenKind::KEYWORD_FUNCTION) {
+        pendingCheck = PendingCheck::FUNCTION_DATATYPE;
     }
 }
 
 /*
-    This function displays the CST, but if there is an error the
-    syntax error will be printed in an output file.
+    This function returns true if a token kind is a reserved word that
+    can't be used as the name of a variable or function. procedure is
+    allowed as a name.
 */
-void ConcreteSyntaxTree::displayCST(std::string outputFilename) {
+bool ConcreteSyntaxTree::isReservedName(TokenKind kind) {
+    switch (kind) {
+        case TokenKind::KEYWORD_INT:
+        case TokenKind::KEYWORD_CHAR:
+        case TokenKind::KEYWORD_BOOL:
+        case TokenKind::KEYWORD_VOID:
+        case TokenKind::KEYWORD_IF:
+        case TokenKind::KEYWORD_ELSE:
+        case TokenKind::KEYWORD_FUNCTION:
+        case TokenKind::KEYWORD_PRINTF:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*
+    This function displays the CST in format, but if there is an error
+    the syntax error will be printed in an output file. The text shows
+    each run of right siblings on a line, while the records are the
+    nodes in order, with the numbers of the nodes they link to or -1.
+*/
+void ConcreteSyntaxTree::displayCST(std::string outputFilename, ReportFormat format) {
     // if there is no root, that means there was an error tokenizing
-    if (!root) {
+    if (root == none) {
         return;
     }
 
-    std::ofstream outFile(outputFilename);
+    ReportWriter outFile(outputFilename, format);
     
     // error detected when creating cst
     if (invalidSyntax) {
-        outFile << "Syntax error on line " << errorLineNumber << ": " << errorType << std::endl;
+        if (outFile.isText()) {
+            outFile << "Syntax error on line " << errorLineNumber << ": " << errorType << '\n';
+            return;
+        }
+        outFile.beginRecord("error");
+        outFile.field("line", errorLineNumber);
+        outFile.field("message", errorType);
+        outFile.endRecord();
+        return;
+    }
+
+    if (!outFile.isText()) {
+        for (unsigned int node = 0; node < kinds.size(); node++) {
+            const char* kind = Tokenization::kindName(kinds[node]);
+            outFile.beginRecord("node");
+            outFile.field("node", node);
+            outFile.field("kind", kind, std::strlen(kind));
+            outFile.field("value", atoms->data(valueAtoms[node]), atoms->length(valueAtoms[node]));
+            outFile.field("line", sourceMap->line(locations[node]));
+            outFile.field("leftChild", leftChildren[node] == none ? -1 : static_cast<long long>(leftChildren[node]));
+            outFile.field("rightSibling", rightSiblings[node] == none ? -1 : static_cast<long long>(rightSiblings[node]));
+            outFile.endRecord();
+        }
         return;
     }
     
@@ -175,21 +416,181 @@ void ConcreteSyntaxTree::displayCST(std::string outputFilename) {
     currentNode = root;
 
     // keep running until both left child and right sibling are null
-    while (currentNode->leftChild || currentNode->rightSibling) {
-        outFile << currentNode->token;
+    while (leftChildren[currentNode] != none ||
+           rightSiblings[currentNode] != none) {
+        outFile.write(atoms->data(valueAtoms[currentNode]), atoms->length(valueAtoms[currentNode]));
 
         // set up to print right sibling or left child
-        if (currentNode->rightSibling) {
+        if (rightSiblings[currentNode] != none) {
             outFile << " -> ";
-            currentNode = currentNode->rightSibling;
+            currentNode = rightSiblings[currentNode];
         }
-        else if (currentNode->leftChild) {
-            outFile << " -> NULL" << std::endl;
-            outFile << "child of " << currentNode->token << ": ";
-            currentNode = currentNode->leftChild;
+        else if (leftChildren[currentNode] != none) {
+            outFile << " -> NULL\n";
+            outFile << "child of ";
+            outFile.write(atoms->data(valueAtoms[currentNode]), atoms->length(valueAtoms[currentNode]));
+            outFile << ": ";
+            currentNode = leftChildren[currentNode];
         }
     }
 
     // print last node
-    outFile << currentNode->token << " -> NULL" << std::endl;
+    outFile.write(atoms->data(valueAtoms[currentNode]), atoms->length(valueAtoms[currentNode]));
+    outFile << " -> NULL\n";
+}
+
+/*
+    This function writes the tree to a binary file that loadCST can
+    read back without the source. The file is a header and then the
+    node arrays, the atom table and the newlines of the source, each
+    as it is in memory. Links are node numbers, so the file can be
+    loaded anywhere. Returns false if there is no tree or the file
+    couldn't be written.
+*/
+bool ConcreteSyntaxTree::saveCST(const std::string &outputFilename) const {
+    if (root == none) {
+        return false;
+    }
+
+    TreeHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, treeMagic, sizeof(treeMagic));
+    header.formatVersion = treeFormatVersion;
+    header.nodeCount = static_cast<std::uint32_t>(kinds.size());
+    header.root = root;
+    header.errorLineNumber = errorLineNumber;
+    header.invalidSyntax = invalidSyntax ? 1 : 0;
+
+    // the lines are found from the newlines, so they are saved found
+    sourceMap->buildIndex();
+
+    // the sections, after room for the header
+    std::string file(sizeof(header), '\0');
+    std::uint64_t* sizes = header.sectionSizes;
+    BinarySections::append(file, sizes[KINDS], kinds.data(), kinds.size());
+    BinarySections::append(file, sizes[VALUE_ATOMS], valueAtoms.data(), valueAtoms.size());
+    BinarySections::append(file, sizes[INTEGER_VALUES], integerValues.data(), integerValues.size());
+    BinarySections::append(file, sizes[LOCATIONS], locations.data(), locations.size());
+    BinarySections::append(file, sizes[LEFT_CHILDREN], leftChildren.data(), leftChildren.size());
+    BinarySections::append(file, sizes[RIGHT_SIBLINGS], rightSiblings.data(), rightSiblings.size());
+    BinarySections::append(file, sizes[ATOM_TEXT], atoms->text.data(), atoms->text.size());
+    BinarySections::append(file, sizes[ATOM_OFFSETS], atoms->offsets.data(), atoms->offsets.size());
+    BinarySections::append(file, sizes[ATOM_HASHES], atoms->hashes.data(), atoms->hashes.size());
+    BinarySections::append(file, sizes[ATOM_SLOTS], atoms->slots.data(), atoms->slots.size());
+    BinarySections::append(file, sizes[NEWLINES], sourceMap->newlines.data(),
+                           sourceMap->newlines.size());
+    BinarySections::append(file, sizes[SKIPPED_NEWLINES], sourceMap->skippedNewlines.data(),
+                           sourceMap->skippedNewlines.size());
+    BinarySections::append(file, sizes[ERROR_TYPE], errorType.data(), errorType.size());
+    unsigned long long headerHash = TokenCache::hash(reinterpret_cast<const char*>(&header),
+                                                     sizeof(header));
+    header.contentHash = TokenCache::hash(file.data() + sizeof(header), file.size() - sizeof(header),
+                                          headerHash);
+    std::memcpy(&file[0], &header, sizeof(header));
+
+    std::ofstream outFile(outputFilename, std::ios::binary | std::ios::trunc);
+    outFile.write(file.data(), file.size());
+    return static_cast<bool>(outFile);
+}
+
+/*
+    This function replaces the tree with one that saveCST wrote. The
+    file is mapped and each array is copied out of it at once. The
+    loaded tree keeps its own names and lines, so it needs no
+    tokenizer. Returns false, and leaves the tree as it was, if the
+    file can't be read, is from another version or is corrupt.
+*/
+bool ConcreteSyntaxTree::loadCST(const std::string &inputFilename) {
+    SourceBuffer file;
+    TreeHeader header;
+    if (!file.open(inputFilename) || file.size() < sizeof(header)) {
+        return false;
+    }
+
+    // check that the file is a tree of this version, and is whole
+    std::memcpy(&header, file.begin(), sizeof(header));
+    std::uint64_t contentHash = header.contentHash;
+    header.contentHash = 0;
+    unsigned long long headerHash = TokenCache::hash(reinterpret_cast<const char*>(&header),
+                                                     sizeof(header));
+    const char* sections[TREE_SECTION_COUNT];
+    if (std::memcmp(header.magic, treeMagic, sizeof(treeMagic)) != 0 ||
+        header.formatVersion != treeFormatVersion ||
+        !BinarySections::locate(file.begin(), file.size(), sizeof(header),
+                                header.sectionSizes, TREE_SECTION_COUNT, sections) ||
+        TokenCache::hash(file.begin() + sizeof(header), file.size() - sizeof(header),
+                         headerHash) != contentHash) {
+        return false;
+    }
+
+    std::vector<TokenKind> newKinds;
+    std::vector<unsigned int> newValueAtoms;
+    std::vector<int> newIntegerValues;
+    std::vector<unsigned int> newLocations;
+    std::vector<unsigned int> newLeftChildren;
+    std::vector<unsigned int> newRightSiblings;
+    AtomTable newAtoms;
+    SourceMap newSourceMap;
+    std::string newErrorType;
+    const std::uint64_t* sizes = header.sectionSizes;
+    if (!BinarySections::read(sections[KINDS], sizes[KINDS], newKinds) ||
+        !BinarySections::read(sections[VALUE_ATOMS], sizes[VALUE_ATOMS], newValueAtoms) ||
+        !BinarySections::read(sections[INTEGER_VALUES], sizes[INTEGER_VALUES], newIntegerValues) ||
+        !BinarySections::read(sections[LOCATIONS], sizes[LOCATIONS], newLocations) ||
+        !BinarySections::read(sections[LEFT_CHILDREN], sizes[LEFT_CHILDREN], newLeftChildren) ||
+        !BinarySections::read(sections[RIGHT_SIBLINGS], sizes[RIGHT_SIBLINGS], newRightSiblings) ||
+        !BinarySections::read(sections[ATOM_TEXT], sizes[ATOM_TEXT], newAtoms.text) ||
+        !BinarySections::read(sections[ATOM_OFFSETS], sizes[ATOM_OFFSETS], newAtoms.offsets) ||
+        !BinarySections::read(sections[ATOM_HASHES], sizes[ATOM_HASHES], newAtoms.hashes) ||
+        !BinarySections::read(sections[ATOM_SLOTS], sizes[ATOM_SLOTS], newAtoms.slots) ||
+        !BinarySections::read(sections[NEWLINES], sizes[NEWLINES], newSourceMap.newlines) ||
+        !BinarySections::read(sections[SKIPPED_NEWLINES], sizes[SKIPPED_NEWLINES],
+                              newSourceMap.skippedNewlines) ||
+        !BinarySections::read(sections[ERROR_TYPE], sizes[ERROR_TYPE], newErrorType)) {
+        return false;
+    }
+
+    // check that every node part is there and every number in them is
+    // a node, atom or kind that exists
+    unsigned int nodeCount = header.nodeCount;
+    if (nodeCount == 0 || header.root >= nodeCount || newKinds.size() != nodeCount ||
+        newValueAtoms.size() != nodeCount || newIntegerValues.size() != nodeCount ||
+        newLocations.size() != nodeCount || newLeftChildren.size() != nodeCount ||
+        newRightSiblings.size() != nodeCount ||
+        !linksAreValid(newLeftChildren, nodeCount) || !linksAreValid(newRightSiblings, nodeCount)) {
+        return false;
+    }
+    if (newAtoms.offsets.empty() || newAtoms.offsets.size() != newAtoms.hashes.size() + 1 ||
+        newAtoms.offsets.back() != newAtoms.text.size() ||
+        newAtoms.slots.size() < 2 * newAtoms.hashes.size() ||
+        (newAtoms.slots.size() & (newAtoms.slots.size() - 1)) != 0) {
+        return false;
+    }
+    for (unsigned int node = 0; node < nodeCount; node++) {
+        if (newValueAtoms[node] >= newAtoms.size() ||
+            newKinds[node] > TokenKind::KEYWORD_PRINTF) {
+            return false;
+        }
+    }
+
+    // the file is good, replace the tree with it
+    kinds.swap(newKinds);
+    valueAtoms.swap(newValueAtoms);
+    integerValues.swap(newIntegerValues);
+    locations.swap(newLocations);
+    leftChildren.swap(newLeftChildren);
+    rightSiblings.swap(newRightSiblings);
+    std::swap(loadedAtoms, newAtoms);
+    loadedSourceMap.newlines.swap(newSourceMap.newlines);
+    loadedSourceMap.skippedNewlines.swap(newSourceMap.skippedNewlines);
+    loadedSourceMap.indexed = true;
+    atoms = &loadedAtoms;
+    sourceMap = &loadedSourceMap;
+    root = header.root;
+    currentNode = none;
+    resetChecks();
+    invalidSyntax = header.invalidSyntax != 0;
+    errorLineNumber = header.errorLineNumber;
+    errorType.swap(newErrorType);
+    return true;
 }
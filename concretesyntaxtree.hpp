@@ -5,46 +5,93 @@
     ConcreteSyntaxTree header file
     Description: The ConcreteSyntaxTree class contains functions
     to create a concrete syntax tree utilizing a Left-Child,
-    Right-Sibling binary tree. This file also contains a TreeNode
-    structure that is used to create the tree.
+    Right-Sibling binary tree. The nodes are numbered in the order
+    they are added and each part of a node is kept in its own vector,
+    indexed by the node's number, so a pass that only needs the kinds
+    reads only the kinds. Links between nodes are node numbers. The
+    tree uses the tokenizer's AtomTable and SourceMap, so the tokenizer
+    has to be kept as long as the tree is. The tree is checked for
+    syntax errors as each node is added, so no second pass over it
+    is needed. A tree can be saved to a binary file and loaded again
+    without its source or tokenizer, see saveCST.
 */
 
 #ifndef CONCRETE_SYNTAX_TREE_HPP
 #define CONCRETE_SYNTAX_TREE_HPP
 
 #include <string>
+#include <vector>
 
 #include "tokenization.hpp"
 
-struct TreeNode {
-    std::string token;
-    int lineNumber;
-    TreeNode* leftChild;
-    TreeNode* rightSibling;
-
-    // tree node constructor
-    TreeNode(std::string data, int lineNum) : 
-        token(data), lineNumber(lineNum), leftChild(nullptr), rightSibling(nullptr) {}
-};
-
 class ConcreteSyntaxTree {
     public:
         // default constructor
         ConcreteSyntaxTree();
 
+        // number of a node that isn't there
+        static const unsigned int none = 0xFFFFFFFFu;
+
         // member functions
-        void createCST(Tokenization& tokenizer);
-        void displayCST(std::string outputFilename);
+        void createCST(Tokenization& tokenizer, bool failFast = false);
+        void createCST(TokenStream& tokens, bool failFast = false);
+        void displayCST(std::string outputFilename, ReportFormat format = ReportFormat::TEXT);
+        bool saveCST(const std::string &outputFilename) const;
+        bool loadCST(const std::string &inputFilename);
+        bool hasSyntaxError() const { return invalidSyntax; }
+        bool isEmpty() const { return root == none; }
 
         // friend class
         friend class SymbolTable;
 
     private:
-        // private function
-        void errorCheckCST();
-        
-        TreeNode* root;
-        TreeNode* currentNode;
+        /*
+            What the next node is checked for, because of the nodes
+            just before it.
+        */
+        enum class PendingCheck : unsigned char {
+            // nothing, the node may start a check of the nodes after it
+            NONE,
+            // the size after a [ must not be negative
+            ARRAY_SIZE,
+            // the name after a datatype must not be a reserved word
+            VARIABLE_NAME,
+            // the datatype of a function, which is skipped
+            FUNCTION_DATATYPE,
+            // the name of a function must not be a reserved word
+            FUNCTION_NAME
+        };
+
+        // private functions
+        void addNode(Tokenization& tokenizer, const Token& token, bool& nextIsChild);
+        void reserveNodes(std::size_t count);
+        void deleteTree();
+        void resetChecks();
+        void checkNode(unsigned int node, bool isSibling);
+        static bool isReservedName(TokenKind kind);
+
+        // the parts of the nodes, by node number
+        std::vector<TokenKind> kinds;
+        // atom of the token's value in the tree's AtomTable
+        std::vector<unsigned int> valueAtoms;
+        std::vector<int> integerValues;
+        // offset of the token in the source, see SourceMap
+        std::vector<unsigned int> locations;
+        std::vector<unsigned int> leftChildren;
+        std::vector<unsigned int> rightSiblings;
+        unsigned int root;
+        unsigned int currentNode;
+        // names of the tokens in the tree, owned by the tokenizer
+        const AtomTable* atoms;
+        // lines of the source, owned by the tokenizer
+        const SourceMap* sourceMap;
+        // names and lines of a tree from loadCST, which has no tokenizer
+        AtomTable loadedAtoms;
+        SourceMap loadedSourceMap;
+        // state of the checks between one node and the next
+        PendingCheck pendingCheck;
+        // true once an error that ends the checks has been found
+        bool checksDone;
         bool invalidSyntax;
         int errorLineNumber;
         std::string errorType;
@@ -0,0 +1,706 @@
+/*
+    Implementation of the Interpreter class
+    by: Kathy
+
+    Description: This file contains the implementations of the
+    Interpreter class functions declared in the header file.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <unordered_map>
+
+#include "interpreter.hpp"
+
+const unsigned int Interpreter::maxCallDepth;
+
+/*
+    The global frame starts after the first int of the stack, which is
+    written to instead of a variable that can't be found after an
+    error.
+*/
+static const std::size_t globalBase = 1;
+
+/*
+    This is the default constructor for the Interpreter class. There
+    is nothing to run until prepare is called.
+*/
+Interpreter::Interpreter() {
+    ast = nullptr;
+    nodes = nullptr;
+    entry = AbstractSyntaxTree::none;
+    globalFrameSize = 0;
+    frameBase = globalBase;
+    returnValue = 0;
+    callDepth = 0;
+    out = nullptr;
+    statements = 0;
+    seconds = 0;
+    invalidRun = false;
+    errorLineNumber = 0;
+    sourceMap = nullptr;
+}
+
+/*
+    This function gets a tree and the symbol table of the same source
+    ready to run. Each node is bound to the slot of the variable it
+    names, or the function it calls, and the procedure main is found.
+    Returns false, with the error kept for displayError, if the
+    program can't be run.
+*/
+bool Interpreter::prepare(const AbstractSyntaxTree &ast, const SymbolTable &symbolTable) {
+    this->ast = &ast;
+    nodes = &ast.nodes;
+    sourceMap = ast.sourceMap;
+    globalFrameSize = symbolTable.globalFrameSize();
+
+    // a program with an error isn't run, and the first error is kept
+    if (ast.hasSyntaxError()) {
+        invalidRun = true;
+        errorLineNumber = ast.errorLineNumber;
+        errorType = ": " + ast.errorType;
+        return false;
+    }
+    if (symbolTable.hasSyntaxError()) {
+        invalidRun = true;
+        errorLineNumber = symbolTable.errorLineNumber;
+        errorType = symbolTable.errorType;
+        return false;
+    }
+    if (ast.root == AbstractSyntaxTree::none) {
+        fail(AbstractSyntaxTree::none, "there is no program to run");
+        return false;
+    }
+
+    // the functions are found by where they start, which is the same
+    // in the tree and the symbol table
+    std::unordered_map<unsigned int, unsigned int> functionSymbols;
+    for (std::size_t i = 0; i < symbolTable.symbols.size(); i++) {
+        const Symbol &symbol = symbolTable.symbols[i];
+        if (symbol.identifierType != IdentifierType::DATATYPE) {
+            functionSymbols[symbolTable.location(symbol)] = static_cast<unsigned int>(i);
+        }
+    }
+
+    bindings.assign(nodes->size(), NodeBinding());
+    std::vector<unsigned int> functionNodes(symbolTable.symbols.size(), AbstractSyntaxTree::none);
+    for (unsigned int node = (*nodes)[ast.root].firstChild; node != AbstractSyntaxTree::none;
+         node = (*nodes)[node].nextSibling) {
+        const AstNode &function = (*nodes)[node];
+        if (function.kind != AstKind::FUNCTION && function.kind != AstKind::PROCEDURE) {
+            continue;
+        }
+        std::unordered_map<unsigned int, unsigned int>::const_iterator found =
+            functionSymbols.find(function.location);
+        if (found == functionSymbols.end()) {
+            fail(node, "the function isn't in the symbol table");
+            return false;
+        }
+        const Symbol &symbol = symbolTable.symbols[found->second];
+        bindings[node].slot = symbol.frameSize;
+        bindings[node].datatype = symbol.datatype;
+        functionNodes[found->second] = node;
+
+        if (function.kind == AstKind::PROCEDURE && entry == AbstractSyntaxTree::none &&
+            ast.atoms->name(function.atom) == "main") {
+            entry = node;
+        }
+    }
+
+    for (unsigned int node = 0; node < nodes->size() && !invalidRun; node++) {
+        const AstNode &current = (*nodes)[node];
+        switch (current.kind) {
+            case AstKind::VARIABLE:
+            case AstKind::INDEX:
+            case AstKind::DECLARATION:
+            case AstKind::PARAMETER:
+                bindVariable(node, symbolTable.symbolAt(current.location));
+                break;
+            case AstKind::CALL: {
+                const Symbol* symbol = symbolTable.symbolAt(current.location);
+                unsigned int function = AbstractSyntaxTree::none;
+                if (symbol && symbol->identifierType != IdentifierType::DATATYPE) {
+                    function = functionNodes[symbol - &symbolTable.symbols[0]];
+                }
+                if (function == AbstractSyntaxTree::none) {
+                    fail(node, "\"" + ast.atoms->name(current.atom) + "\" is not a function or procedure");
+                    break;
+                }
+                bindings[node].slot = function;
+                bindings[node].datatype = symbol->datatype;
+                break;
+            }
+            case AstKind::STRING:
+                bindings[node].slot = static_cast<unsigned int>(strings.size());
+                strings.push_back(unescape(ast.atoms->name(current.atom)));
+                break;
+            default:
+                break;
+        }
+    }
+
+    // the values of each call have to fit its parameters, which are
+    // all bound now
+    for (unsigned int node = 0; node < nodes->size() && !invalidRun; node++) {
+        const AstNode &current = (*nodes)[node];
+        if (current.kind == AstKind::ASSIGNMENT && bindings[current.firstChild].isArray &&
+            (*nodes)[current.firstChild].kind == AstKind::VARIABLE) {
+            fail(node, "an array can't be assigned to");
+        }
+        if (current.kind != AstKind::CALL) {
+            continue;
+        }
+
+        unsigned int parameter = (*nodes)[bindings[node].slot].firstChild;
+        unsigned int argument = current.firstChild;
+        while (parameter != AbstractSyntaxTree::none && argument != AbstractSyntaxTree::none &&
+               (*nodes)[parameter].kind == AstKind::PARAMETER) {
+            bool isArrayArgument = (*nodes)[argument].kind == AstKind::VARIABLE && bindings[argument].isArray;
+            if (bindings[parameter].isArray != isArrayArgument) {
+                fail(argument, bindings[parameter].isArray ? "an array has to be passed to \"" +
+                                                             ast.atoms->name((*nodes)[parameter].atom) + "\""
+                                                           : "an array can't be passed to \"" +
+                                                             ast.atoms->name((*nodes)[parameter].atom) + "\"");
+                break;
+            }
+            parameter = (*nodes)[parameter].nextSibling;
+            argument = (*nodes)[argument].nextSibling;
+        }
+        if (!invalidRun && (argument != AbstractSyntaxTree::none ||
+                            (parameter != AbstractSyntaxTree::none &&
+                             (*nodes)[parameter].kind == AstKind::PARAMETER))) {
+            fail(node, "\"" + ast.atoms->name(current.atom) + "\" is called with the wrong number of values");
+        }
+    }
+
+    if (!invalidRun && entry == AbstractSyntaxTree::none) {
+        fail(AbstractSyntaxTree::none, "there is no procedure main to run");
+    }
+    else if (!invalidRun && (*nodes)[(*nodes)[entry].firstChild].kind == AstKind::PARAMETER) {
+        fail(entry, "the procedure main can't have parameters");
+    }
+    return !invalidRun;
+}
+
+/*
+    This function binds a node that names a variable or parameter to
+    the slot of its symbol. Returns false if the name isn't one.
+*/
+bool Interpreter::bindVariable(unsigned int node, const Symbol* symbol) {
+    const AstNode &current = (*nodes)[node];
+    if (!symbol) {
+        fail(node, "\"" + ast->atoms->name(current.atom) + "\" is not declared");
+        return false;
+    }
+    if (symbol->frameSlot == Symbol::noSlot) {
+        fail(node, "\"" + ast->atoms->name(current.atom) + "\" is not a variable");
+        return false;
+    }
+    if (current.kind == AstKind::INDEX && !symbol->isArray) {
+        fail(node, "\"" + ast->atoms->name(current.atom) + "\" is not an array");
+        return false;
+    }
+
+    NodeBinding &binding = bindings[node];
+    binding.slot = symbol->frameSlot;
+    binding.arraySize = symbol->arraySize;
+    binding.datatype = symbol->datatype;
+    binding.isGlobal = (symbol->scopeIndex == SymbolTable::globalScope);
+    binding.isArray = symbol->isArray;
+    return true;
+}
+
+/*
+    This function runs the program from the procedure main, after the
+    global declarations, and writes what it prints to out. Returns
+    false if it stopped on an error.
+*/
+bool Interpreter::run(std::ostream &out) {
+    if (invalidRun || entry == AbstractSyntaxTree::none) {
+        return false;
+    }
+    this->out = &out;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    memory.assign(globalBase + globalFrameSize, 0);
+    for (unsigned int node = (*nodes)[ast->root].firstChild; node != AbstractSyntaxTree::none;
+         node = (*nodes)[node].nextSibling) {
+        if ((*nodes)[node].kind == AstKind::DECLARATION) {
+            declare(node);
+        }
+    }
+
+    std::size_t entryBase = memory.size();
+    memory.resize(entryBase + bindings[entry].slot, 0);
+    frameBase = entryBase;
+    callDepth = 1;
+    executeBlock((*nodes)[entry].firstChild);
+    callDepth = 0;
+
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    flushOutput();
+    return !invalidRun;
+}
+
+/*
+    This function runs one statement.
+*/
+Interpreter::Flow Interpreter::execute(unsigned int node) {
+    const AstNode &statement = (*nodes)[node];
+    if (statement.kind == AstKind::BLOCK) {
+        return executeBlock(node);
+    }
+    statements++;
+
+    switch (statement.kind) {
+        case AstKind::DECLARATION:
+            declare(node);
+            break;
+        case AstKind::ASSIGNMENT:
+            assign(node);
+            break;
+        case AstKind::CALL_STATEMENT:
+            evaluate(statement.firstChild);
+            break;
+        case AstKind::PRINTF:
+            print(node);
+            break;
+        case AstKind::IF: {
+            unsigned int condition = statement.firstChild;
+            unsigned int thenStatement = (*nodes)[condition].nextSibling;
+            unsigned int elseStatement = (*nodes)[thenStatement].nextSibling;
+            bool isTrue = evaluate(condition) != 0;
+            if (invalidRun) {
+                return Flow::RETURN;
+            }
+            if (isTrue) {
+                return execute(thenStatement);
+            }
+            if (elseStatement != AbstractSyntaxTree::none) {
+                return execute(elseStatement);
+            }
+            break;
+        }
+        case AstKind::WHILE: {
+            unsigned int condition = statement.firstChild;
+            unsigned int body = (*nodes)[condition].nextSibling;
+            while (evaluate(condition) != 0 && !invalidRun) {
+                if (execute(body) == Flow::RETURN) {
+                    return Flow::RETURN;
+                }
+            }
+            break;
+        }
+        case AstKind::FOR: {
+            // a part that is left out is an EMPTY node
+            unsigned int initial = statement.firstChild;
+            unsigned int condition = (*nodes)[initial].nextSibling;
+            unsigned int step = (*nodes)[condition].nextSibling;
+            unsigned int body = (*nodes)[step].nextSibling;
+            bool hasCondition = (*nodes)[condition].kind != AstKind::EMPTY;
+
+            if ((*nodes)[initial].kind != AstKind::EMPTY) {
+                execute(initial);
+            }
+            while (!invalidRun && (!hasCondition || evaluate(condition) != 0) && !invalidRun) {
+                if (execute(body) == Flow::RETURN) {
+                    return Flow::RETURN;
+                }
+                if ((*nodes)[step].kind != AstKind::EMPTY) {
+                    execute(step);
+                }
+            }
+            break;
+        }
+        case AstKind::RETURN:
+            returnValue = (statement.firstChild != AbstractSyntaxTree::none) ? evaluate(statement.firstChild) : 0;
+            return Flow::RETURN;
+        default:
+            break;
+    }
+    return invalidRun ? Flow::RETURN : Flow::NEXT;
+}
+
+/*
+    This function runs the statements of a block. The arrays declared
+    in it are taken off the stack at its end.
+*/
+Interpreter::Flow Interpreter::executeBlock(unsigned int block) {
+    std::size_t stackTop = memory.size();
+    Flow flow = Flow::NEXT;
+    for (unsigned int node = (*nodes)[block].firstChild; node != AbstractSyntaxTree::none;
+         node = (*nodes)[node].nextSibling) {
+        flow = execute(node);
+        if (flow == Flow::RETURN) {
+            break;
+        }
+    }
+    memory.resize(stackTop);
+    return flow;
+}
+
+/*
+    This function runs a declaration, which sets a variable to 0, or
+    puts the elements of an array on the stack, set to 0.
+*/
+void Interpreter::declare(unsigned int node) {
+    const NodeBinding &binding = bindings[node];
+    std::size_t slot = (binding.isGlobal ? globalBase : frameBase) + binding.slot;
+    if (!binding.isArray) {
+        memory[slot] = 0;
+        return;
+    }
+    std::size_t elements = memory.size();
+    memory.resize(elements + (binding.arraySize > 0 ? binding.arraySize : 0), 0);
+    memory[slot] = static_cast<int>(elements);
+}
+
+/*
+    This function runs an assignment. The index of an array element is
+    worked out before the value.
+*/
+void Interpreter::assign(unsigned int node) {
+    unsigned int target = (*nodes)[node].firstChild;
+    std::size_t location = address(target);
+    int value = evaluate((*nodes)[target].nextSibling);
+    if (!invalidRun) {
+        memory[location] = convert(value, bindings[target].datatype);
+    }
+}
+
+/*
+    This function runs a printf. All of the values are worked out
+    before anything is printed. %d prints an int, %c a char, %s a
+    string or a char array up to its first 0, and %% a %.
+*/
+void Interpreter::print(unsigned int node) {
+    unsigned int format = (*nodes)[node].firstChild;
+    std::vector<unsigned int> valueNodes;
+    std::vector<int> values;
+    for (unsigned int value = (*nodes)[format].nextSibling; value != AbstractSyntaxTree::none;
+         value = (*nodes)[value].nextSibling) {
+        valueNodes.push_back(value);
+        values.push_back((*nodes)[value].kind == AstKind::STRING ? 0 : evaluate(value));
+    }
+    if (invalidRun) {
+        return;
+    }
+
+    const std::string &text = strings[bindings[format].slot];
+    std::size_t nextValue = 0;
+    std::size_t runStart = 0;
+    for (std::size_t i = 0; i + 1 < text.size(); i++) {
+        if (text[i] != '%') {
+            continue;
+        }
+        write(text.data() + runStart, i - runStart);
+        char conversion = text[++i];
+        runStart = i + 1;
+
+        if (conversion == '%') {
+            write("%", 1);
+            continue;
+        }
+        if (conversion != 'd' && conversion != 'c' && conversion != 's') {
+            // anything else is printed as it is
+            runStart = i - 1;
+            continue;
+        }
+        if (nextValue >= values.size()) {
+            fail(node, "printf is given fewer values than its format needs");
+            return;
+        }
+
+        unsigned int valueNode = valueNodes[nextValue];
+        int value = values[nextValue++];
+        if (conversion == 'd') {
+            std::string digits = std::to_string(value);
+            write(digits.data(), digits.size());
+        }
+        else if (conversion == 'c') {
+            char character = static_cast<char>(value);
+            write(&character, 1);
+        }
+        else if ((*nodes)[valueNode].kind == AstKind::STRING) {
+            const std::string &string = strings[bindings[valueNode].slot];
+            write(string.data(), string.size());
+        }
+        else if ((*nodes)[valueNode].kind == AstKind::VARIABLE && bindings[valueNode].isArray) {
+            // the array's value is where its elements start
+            std::size_t end = std::min(memory.size(), static_cast<std::size_t>(value) +
+                                                      static_cast<std::size_t>(bindings[valueNode].arraySize));
+            for (std::size_t element = value; element < end && memory[element] != 0; element++) {
+                char character = static_cast<char>(memory[element]);
+                write(&character, 1);
+            }
+        }
+        else {
+            fail(valueNode, "%s needs a string or a char array");
+            return;
+        }
+    }
+    write(text.data() + runStart, text.size() - runStart);
+}
+
+/*
+    This function works out the value of an expression. An array's
+    value is where its elements start on the stack.
+*/
+int Interpreter::evaluate(unsigned int node) {
+    const AstNode &expression = (*nodes)[node];
+    switch (expression.kind) {
+        case AstKind::INTEGER:
+        case AstKind::CHARACTER:
+            return expression.value;
+        case AstKind::VARIABLE:
+        case AstKind::INDEX:
+            return memory[address(node)];
+        case AstKind::CALL:
+            return call(node);
+        case AstKind::UNARY: {
+            int operand = evaluate(expression.firstChild);
+            if (expression.type == TokenKind::BOOLEAN_NOT) {
+                return operand == 0;
+            }
+            return static_cast<int>(0u - static_cast<unsigned int>(operand));
+        }
+        case AstKind::BINARY:
+            return evaluateBinary(node);
+        default:
+            fail(node, "a string can only be printed");
+            return 0;
+    }
+}
+
+/*
+    This function works out the value of a binary operator. && and ||
+    only work out their right operand if they need it. Arithmetic
+    wraps around instead of overflowing.
+*/
+int Interpreter::evaluateBinary(unsigned int node) {
+    const AstNode &expression = (*nodes)[node];
+    unsigned int rightNode = (*nodes)[expression.firstChild].nextSibling;
+    int left = evaluate(expression.firstChild);
+
+    if (expression.type == TokenKind::BOOLEAN_AND) {
+        return left != 0 && evaluate(rightNode) != 0;
+    }
+    if (expression.type == TokenKind::BOOLEAN_OR) {
+        return left != 0 || evaluate(rightNode) != 0;
+    }
+
+    int right = evaluate(rightNode);
+    unsigned int leftBits = static_cast<unsigned int>(left);
+    unsigned int rightBits = static_cast<unsigned int>(right);
+    switch (expression.type) {
+        case TokenKind::PLUS: return static_cast<int>(leftBits + rightBits);
+        case TokenKind::MINUS: return static_cast<int>(leftBits - rightBits);
+        case TokenKind::ASTERISK: return static_cast<int>(leftBits * rightBits);
+        case TokenKind::DIVIDE:
+        case TokenKind::MODULO:
+            if (right == 0) {
+                fail(node, "division by zero");
+                return 0;
+            }
+            if (left == INT_MIN && right == -1) {
+                return (expression.type == TokenKind::DIVIDE) ? INT_MIN : 0;
+            }
+            return (expression.type == TokenKind::DIVIDE) ? left / right : left % right;
+        case TokenKind::CARET: return power(left, right);
+        case TokenKind::LESS_THAN: return left < right;
+        case TokenKind::GREATER_THAN: return left > right;
+        case TokenKind::LESS_THAN_OR_EQUAL: return left <= right;
+        case TokenKind::GREATER_THAN_OR_EQUAL: return left >= right;
+        case TokenKind::BOOLEAN_EQUAL: return left == right;
+        case TokenKind::NOT_EQUAL: return left != right;
+        default: return 0;
+    }
+}
+
+/*
+    This function calls a function or procedure. The values are worked
+    out in the caller's frame and put in the slots of the parameters
+    in the new frame, an array as where its elements start. Returns
+    the value the function returns, or 0.
+*/
+int Interpreter::call(unsigned int node) {
+    unsigned int function = bindings[node].slot;
+    if (callDepth >= maxCallDepth) {
+        fail(node, "too many calls are running at once");
+        return 0;
+    }
+
+    std::size_t callBase = memory.size();
+    memory.resize(callBase + bindings[function].slot, 0);
+
+    unsigned int parameter = (*nodes)[function].firstChild;
+    for (unsigned int argument = (*nodes)[node].firstChild; argument != AbstractSyntaxTree::none;
+         argument = (*nodes)[argument].nextSibling) {
+        const NodeBinding &binding = bindings[parameter];
+        int value = evaluate(argument);
+        memory[callBase + binding.slot] = binding.isArray ? value : convert(value, binding.datatype);
+        parameter = (*nodes)[parameter].nextSibling;
+    }
+    if (invalidRun) {
+        memory.resize(callBase);
+        return 0;
+    }
+
+    // the body is the BLOCK after the parameters
+    std::size_t callerBase = frameBase;
+    frameBase = callBase;
+    callDepth++;
+    returnValue = 0;
+    executeBlock(parameter);
+    int result = convert(returnValue, bindings[node].datatype);
+    returnValue = 0;
+    callDepth--;
+    frameBase = callerBase;
+    memory.resize(callBase);
+    return result;
+}
+
+/*
+    This function returns the index in the stack of the variable or
+    array element a VARIABLE or INDEX node names. An index outside of
+    the array is an error.
+*/
+std::size_t Interpreter::address(unsigned int node) {
+    const NodeBinding &binding = bindings[node];
+    std::size_t slot = (binding.isGlobal ? globalBase : frameBase) + binding.slot;
+    if ((*nodes)[node].kind != AstKind::INDEX) {
+        return slot;
+    }
+
+    // the array's slot holds where its elements start
+    std::size_t elements = static_cast<std::size_t>(memory[slot]);
+    int index = evaluate((*nodes)[node].firstChild);
+    if (invalidRun) {
+        return 0;
+    }
+    if (index < 0 || index >= binding.arraySize || elements + index >= memory.size()) {
+        fail(node, "index " + std::to_string(index) + " is outside of \"" +
+                   ast->atoms->name((*nodes)[node].atom) + "\"");
+        return 0;
+    }
+    return elements + index;
+}
+
+/*
+    This function writes what printf prints, a block at a time.
+*/
+void Interpreter::write(const char* text, std::size_t length) {
+    output.append(text, length);
+    if (output.size() >= (1 << 16)) {
+        flushOutput();
+    }
+}
+
+/*
+    This function writes what printf has printed so far to out.
+*/
+void Interpreter::flushOutput() {
+    if (out && !output.empty()) {
+        out->write(output.data(), output.size());
+        output.clear();
+    }
+}
+
+/*
+    This function keeps the first error found, on the line of a node,
+    and stops the program. A node of none has no line.
+*/
+void Interpreter::fail(unsigned int node, const std::string &message) {
+    if (invalidRun) {
+        return;
+    }
+    invalidRun = true;
+    errorLineNumber = (node != AbstractSyntaxTree::none && sourceMap) ?
+                      sourceMap->line((*nodes)[node].location) : 0;
+    errorType = ": " + message;
+}
+
+/*
+    This function displays the error that stopped the program.
+*/
+void Interpreter::displayError(std::ostream &out) const {
+    if (errorLineNumber > 0) {
+        out << "Error on line " << errorLineNumber << errorType << '\n';
+    }
+    else {
+        out << "Error" << errorType << '\n';
+    }
+}
+
+/*
+    This function displays how many statements were run and how many
+    were run each second.
+*/
+void Interpreter::displayThroughput(std::ostream &out) const {
+    double perSecond = (seconds > 0) ? statements / seconds : 0;
+    out << "Ran " << statements << " statements in " << seconds << " seconds, "
+        << static_cast<unsigned long long>(perSecond) << " statements per second\n";
+}
+
+/*
+    This function returns a value as it is stored in a variable of a
+    datatype.
+*/
+int Interpreter::convert(int value, SymbolDatatype datatype) {
+    switch (datatype) {
+        case SymbolDatatype::CHAR: return static_cast<signed char>(value);
+        case SymbolDatatype::BOOL: return value != 0;
+        default: return value;
+    }
+}
+
+/*
+    This function returns base to the power of exponent, which is 0 for
+    a negative exponent unless base is 1 or -1.
+*/
+int Interpreter::power(int base, int exponent) {
+    if (exponent < 0) {
+        if (base == 1) {
+            return 1;
+        }
+        if (base == -1) {
+            return (exponent % 2 == 0) ? 1 : -1;
+        }
+        return 0;
+    }
+
+    unsigned int result = 1;
+    unsigned int factor = static_cast<unsigned int>(base);
+    while (exponent > 0) {
+        if (exponent & 1) {
+            result *= factor;
+        }
+        factor *= factor;
+        exponent >>= 1;
+    }
+    return static_cast<int>(result);
+}
+
+/*
+    This function returns the text of a string with its escape
+    sequences turned into the characters they stand for.
+*/
+std::string Interpreter::unescape(const std::string &text) {
+    std::string result;
+    result.reserve(text.size());
+    for (std::size_t i = 0; i < text.size(); i++) {
+        if (text[i] != '\\' || i + 1 == text.size()) {
+            result.push_back(text[i]);
+            continue;
+        }
+        switch (text[++i]) {
+            case 'n': result.push_back('\n'); break;
+            case 't': result.push_back('\t'); break;
+            case 'r': result.push_back('\r'); break;
+            case '0': result.push_back('\0'); break;
+            default: result.push_back(text[i]); break;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,127 @@
+/*
+    Interpreter header file
+    by: Kathy
+
+    Description: The Interpreter class runs a program by walking its
+    abstract syntax tree, starting at the procedure main. Before it
+    runs, every node that names a variable, parameter or function is
+    given what it needs from the symbol table: the slot of the
+    variable in its frame, or the node of the function, so no name is
+    looked up while the program runs.
+
+    The values of the variables are kept in one vector of ints that is
+    used as a stack. The global frame is at the bottom, and each call
+    puts the frame of the function, as many slots as the symbol table
+    gave it, on top. The slot of an array holds the index in the stack
+    where its elements start, which are put on the stack when its
+    declaration is run and taken off again at the end of its block.
+    int, char and bool are all kept as ints, a char is cut to 8 bits
+    and a bool to 0 or 1 when it is stored.
+
+    The number of statements run and the time they took are kept, so
+    the speed of the interpreter can be reported in statements per
+    second.
+*/
+
+#ifndef INTERPRETER_HPP
+#define INTERPRETER_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "abstractsyntaxtree.hpp"
+#include "symboltable.hpp"
+
+class Interpreter {
+    public:
+        // default constructor
+        Interpreter();
+
+        // member functions
+        bool prepare(const AbstractSyntaxTree &ast, const SymbolTable &symbolTable);
+        bool run(std::ostream &out);
+        bool hasRunError() const { return invalidRun; }
+        void displayError(std::ostream &out) const;
+        void displayThroughput(std::ostream &out) const;
+        unsigned long long statementCount() const { return statements; }
+        double runSeconds() const { return seconds; }
+
+        // most calls that can be running at once
+        static const unsigned int maxCallDepth = 2000;
+
+    private:
+        /*
+            What a node needs from the symbol table to be run.
+        */
+        struct NodeBinding {
+            // slot of a variable, parameter or declaration, the frame
+            // size of a function, the node of the function a CALL
+            // calls, or the index of a STRING's text in strings
+            unsigned int slot;
+            // size of an array
+            int arraySize;
+            SymbolDatatype datatype;
+            bool isGlobal;
+            bool isArray;
+
+            NodeBinding() : slot(0), arraySize(0), datatype(SymbolDatatype::INT),
+                            isGlobal(false), isArray(false) {}
+        };
+
+        /*
+            What happens after a statement is run.
+        */
+        enum class Flow : unsigned char {
+            // the next statement is run
+            NEXT,
+            // the function returns, or the program stops on an error
+            RETURN
+        };
+
+        // private functions
+        bool bindVariable(unsigned int node, const Symbol* symbol);
+        Flow execute(unsigned int node);
+        Flow executeBlock(unsigned int block);
+        void declare(unsigned int node);
+        void assign(unsigned int node);
+        void print(unsigned int node);
+        int evaluate(unsigned int node);
+        int evaluateBinary(unsigned int node);
+        int call(unsigned int node);
+        std::size_t address(unsigned int node);
+        void write(const char* text, std::size_t length);
+        void flushOutput();
+        void fail(unsigned int node, const std::string &message);
+        static int convert(int value, SymbolDatatype datatype);
+        static int power(int base, int exponent);
+        static std::string unescape(const std::string &text);
+
+        // the tree being run and its nodes
+        const AbstractSyntaxTree* ast;
+        const std::vector<AstNode>* nodes;
+        // what each node of the tree needs, by node index
+        std::vector<NodeBinding> bindings;
+        // the texts of the STRING nodes, with escape sequences done
+        std::vector<std::string> strings;
+        // the PROCEDURE node of main
+        unsigned int entry;
+        unsigned int globalFrameSize;
+        // the variables of the global frame and every running call
+        std::vector<int> memory;
+        std::size_t frameBase;
+        int returnValue;
+        unsigned int callDepth;
+        // what printf has written that isn't in out yet
+        std::string output;
+        std::ostream* out;
+        unsigned long long statements;
+        double seconds;
+        bool invalidRun;
+        int errorLineNumber;
+        std::string errorType;
+        // lines of the source, owned by the tokenizer
+        const SourceMap* sourceMap;
+};
+
+#endif
@@ -6,50 +6,226 @@
     the program and is used to read in user's input files
     to remove comments and tokenize the code.
 */
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 
+#include "sourcebuffer.hpp"
 #include "removecomments.hpp"
 #include "tokenization.hpp"
+#include "tokencache.hpp"
 #include "concretesyntaxtree.hpp"
 #include "symboltable.hpp"
+#include "abstractsyntaxtree.hpp"
+#include "interpreter.hpp"
 
 int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <filename>\n";
+    // --write-stripped keeps the comments-removed source on disk for debugging
+    bool writeStripped = false;
+    // --stream-tokens only displays the tokens, reading the file in chunks
+    bool streamTokens = false;
+    // --threads N tokenizes the whole file on N threads before parsing it,
+    // and reads the functions into the symbol table on N threads
+    unsigned int threadCount = 0;
+    // --cache DIR reuses the tokens of an unchanged file from DIR
+    std::string cacheDirectory;
+    // --ast also parses the tokens into an abstract syntax tree
+    bool writeAst = false;
+    // --fail-fast stops parsing at the first syntax error and reports it
+    bool failFast = false;
+    // --run also runs the program from its procedure main, and reports
+    // the statements run per second
+    bool runProgram = false;
+    // --save-tree FILE writes the concrete syntax tree to FILE
+    std::string saveTreeFile;
+    // --load-tree FILE uses the tree in FILE instead of parsing the source
+    std::string loadTreeFile;
+    // --format text|jsonl|binary is the format of the output files
+    ReportFormat format = ReportFormat::TEXT;
+    bool validFormat = true;
+    std::string inputFile;
+
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--write-stripped") {
+            writeStripped = true;
+        }
+        else if (argument == "--stream-tokens") {
+            streamTokens = true;
+        }
+        else if (argument == "--threads" && i + 1 < argc) {
+            threadCount = std::atoi(argv[++i]);
+        }
+        else if (argument == "--cache" && i + 1 < argc) {
+            cacheDirectory = argv[++i];
+        }
+        else if (argument == "--ast") {
+            writeAst = true;
+        }
+        else if (argument == "--run") {
+            runProgram = true;
+        }
+        else if (argument == "--fail-fast") {
+            failFast = true;
+        }
+        else if (argument == "--save-tree" && i + 1 < argc) {
+            saveTreeFile = argv[++i];
+        }
+        else if (argument == "--load-tree" && i + 1 < argc) {
+            loadTreeFile = argv[++i];
+        }
+        else if (argument == "--format" && i + 1 < argc) {
+            validFormat = ReportWriter::parseFormat(argv[++i], format);
+        }
+        else if (inputFile.empty()) {
+            inputFile = argument;
+        }
+        else {
+            inputFile = "";
+            break;
+        }
+    }
+
+    if (inputFile.empty() || !validFormat) {
+        std::cerr << "Usage: " << argv[0] << " [--write-stripped] [--stream-tokens] [--threads N] [--cache DIR] [--ast] [--run] [--fail-fast] [--save-tree FILE] [--load-tree FILE] [--format text|jsonl|binary] <filename>\n";
         return 1;
     }
 
+    // the output files are named for the input file and the format
+    std::string extension = ReportWriter::extension(format);
+
+    if (streamTokens) {
+        // tokens are displayed as they are found, in bounded memory
+        std::string baseName = inputFile.substr(0, inputFile.size() - 2);
+        Tokenization tokenizer;
+        tokenizer.displayTokenStream(inputFile, "output-" + baseName + extension, format);
+        return 0;
+    }
+
+    if (!loadTreeFile.empty()) {
+        // the saved tree is used as it is, the source isn't read
+        std::string baseName = inputFile.substr(0, inputFile.size() - 2);
+        ConcreteSyntaxTree cst;
+        if (!cst.loadCST(loadTreeFile)) {
+            std::cout << "Error: Unable to load the tree in " << loadTreeFile << "." << std::endl;
+            return 1;
+        }
+
+        // the tree may have been saved with --fail-fast, so it may stop at the error
+        if (cst.isEmpty()) {
+            return 0;
+        }
+        if (cst.hasSyntaxError()) {
+            cst.displayCST("output-" + baseName + extension, format);
+            return 0;
+        }
+        SymbolTable symbolTable;
+        symbolTable.createSymbolTable(cst, threadCount > 0 ? threadCount : 1);
+        symbolTable.displaySymbolTable("output-" + baseName + extension, format);
+        return 0;
+    }
+
     // Open the file specified in the command-line argument
-    std::string inputFile = argv[1];
-    
+    SourceBuffer source;
+    if (!source.open(inputFile)) {
+        std::cout << "Error: Unable to open input file to remove comments." << std::endl;
+        return 1;
+    }
+
     std::string outputFile = inputFile;
     // modify outputFile name to be similar to input file
     outputFile.pop_back();
     outputFile.pop_back();
-    outputFile += "-comments_replaced_with_white_space.c";
-    
-    // remove comments from input file
-    RemoveComments::removeComments(inputFile, outputFile);
 
-    // tokenize the output file
+    // the tokens refer to the source, so it is kept until the end
     Tokenization tokenizer;
-    tokenizer.tokenize(outputFile);
+    std::string strippedSource;
+    const char* tokenSource = source.begin();
+    const char* tokenSourceEnd = source.end();
+    if (writeStripped) {
+        // remove comments from the source in memory and keep a copy on disk
+        RemoveComments::removeComments(source.begin(), source.end(), strippedSource);
+
+        std::ofstream strippedFile(outputFile + "-comments_replaced_with_white_space.c");
+        strippedFile << strippedSource;
+
+        // tokenize the source without comments
+        tokenSource = strippedSource.data();
+        tokenSourceEnd = strippedSource.data() + strippedSource.size();
+    }
 
     // modify output file name
     inputFile.pop_back();
     inputFile.pop_back();
-    outputFile = "output-" + inputFile + ".txt";
-    //tokenizer.displayTokens(outputFile);
+    outputFile = "output-" + inputFile + extension;
 
-    // create cst from the tokenizer's list
+    // create cst, the parser reads the tokens as it needs them,
+    // skipping comments unless they were already removed
     ConcreteSyntaxTree cst;
-    cst.createCST(tokenizer);
+    if (!cacheDirectory.empty()) {
+        TokenCache cache(cacheDirectory);
+        cache.tokenize(tokenizer, tokenSource, tokenSourceEnd, !writeStripped,
+                       threadCount > 0 ? threadCount : 1);
+        cst.createCST(tokenizer, failFast);
+    }
+    else if (threadCount > 0 || writeAst || runProgram) {
+        // the abstract syntax tree needs the whole token list
+        tokenizer.tokenizeParallel(tokenSource, tokenSourceEnd, !writeStripped, threadCount);
+        //tokenizer.displayTokens(outputFile);
+        cst.createCST(tokenizer, failFast);
+    }
+    else {
+        TokenStream tokens(tokenizer, tokenSource, tokenSourceEnd, !writeStripped);
+        cst.createCST(tokens, failFast);
+    }
     //cst.displayCST(outputFile);
 
+    if (!saveTreeFile.empty() && !cst.saveCST(saveTreeFile)) {
+        std::cout << "Error: Unable to save the tree to " << saveTreeFile << "." << std::endl;
+    }
+
+    // there is no tree if the source couldn't be tokenized, so only
+    // the tokenizer's error is displayed
+    if (cst.isEmpty()) {
+        if (tokenizer.hasInvalidToken()) {
+            tokenizer.displayTokens(outputFile, format);
+        }
+        return 0;
+    }
+
+    // the tree stops at the error, so only the error is displayed
+    if (failFast && cst.hasSyntaxError()) {
+        cst.displayCST(outputFile, format);
+        return 0;
+    }
+
     // create symbol table
     SymbolTable symbolTable;
-    symbolTable.createSymbolTable(cst);
-    symbolTable.displaySymbolTable(outputFile);
+    symbolTable.createSymbolTable(cst, threadCount > 0 ? threadCount : 1);
+    symbolTable.displaySymbolTable(outputFile, format);
+
+    // create the abstract syntax tree from the same tokens
+    if (writeAst || runProgram) {
+        AbstractSyntaxTree ast;
+        ast.createAST(tokenizer);
+        if (writeAst) {
+            ast.displayAST("output-" + inputFile + "-ast" + extension, format);
+        }
+
+        // run the program, printing what it prints
+        if (runProgram) {
+            Interpreter interpreter;
+            if (interpreter.prepare(ast, symbolTable)) {
+                interpreter.run(std::cout);
+                std::cout.flush();
+                interpreter.displayThroughput(std::cerr);
+            }
+            if (interpreter.hasRunError()) {
+                interpreter.displayError(std::cout);
+                return 1;
+            }
+        }
+    }
 
     return 0;
 }
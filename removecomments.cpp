@@ -10,111 +10,172 @@
 #include <iostream>
 
 #include "removecomments.hpp"
-
-/*
-    States to determine what type of comment is being read.
-*/
-enum class State {
-    START,
-    SINGLELINE,
-    MULTILINE,
-    STRING
-};
+#include "charscan.hpp"
+#include "sourcebuffer.hpp"
 
 /*
     This function removes comments from a .c file and outputs a
     .c file where the comments are replaced with whitespace.
 */
 void RemoveComments::removeComments(const std::string &inputFilename, const std::string &outputFilename) {
-    std::ifstream inFile(inputFilename);
-    std::ofstream outFile(outputFilename);
-
-    int lineNumber = 1; // there's no line 0... :)
-    int beginComment = 0;
+    SourceBuffer inFile;
 
     // Check if input file exists
-    if (!inFile) {
+    if (!inFile.open(inputFilename)) {
         std::cout << "Error: Unable to open input file to remove comments." << std::endl;
         return;
     }
 
+    std::string output;
+    removeComments(inFile.begin(), inFile.end(), output);
+
+    std::ofstream outFile(outputFilename, std::ios::binary);
+    outFile.write(output.data(), output.size());
+}
+
+/*
+    This function prints the error for a comment that is never closed
+    (or closed without being opened) on the given line.
+*/
+void RemoveComments::unterminatedComment(int lineNumber) {
+    std::cout << "ERROR: Program contains C - style, unterminated comment on line "
+              << lineNumber << std::endl;
+}
+
+/*
+    This function removes comments from source code that is already
+    in memory and returns the source with the comments replaced with
+    whitespace, so the tokenizer can use it without a file in between.
+*/
+std::string RemoveComments::removeCommentsFromSource(const std::string &source) {
+    std::string output;
+    removeComments(source.data(), source.data() + source.size(), output);
+    return output;
+}
+
+/*
+    This function walks the characters from begin to end and appends
+    them to output with the comments replaced with whitespace. Only
+    the characters that can change the state are looked at one at a
+    time, the runs in between are copied or blanked all at once.
+*/
+void RemoveComments::removeComments(const char* begin, const char* end, std::string &output) {
+    int lineNumber = 1; // there's no line 0... :)
+    int beginComment = 0;
+
     // Check if input file is empty
-    if (inFile.peek() == EOF) {
+    if (begin == end) {
         std::cout << "Input file is empty." << std::endl;
         return;
     }
 
-    State currentState = State::START;
+    // newlines in comments become " \n", so this is usually enough room
+    output.reserve(output.size() + (end - begin) + (end - begin) / 16);
+
+    CommentState currentState = CommentState::START;
+    const char* current = begin;
+    const char* next;
     char currentChar;
+    int nextChar;
 
-    while (inFile.get(currentChar)) {
-        if (currentChar == '\n') {
-            lineNumber++;
-        }
+    while (current != end) {
         switch (currentState) {
             // State for anything not in a comment
-            case State::START:
-                if (currentChar == '"') {
-                    currentState = State::STRING;
+            case CommentState::START:
+                // copy everything up to the next character that matters
+                next = CharScan::findAny(current, end, '/', '*', '"', '\n');
+                output.append(current, next);
+                current = next;
+                if (current == end) {
+                    break;
                 }
-                if (currentChar == '*' && inFile.peek() == '/') {
-                    std::cout << "ERROR: Program contains C - style, unterminated comment on line "
-                              << lineNumber << std::endl;
+
+                currentChar = *current++;
+                nextChar = (current != end) ? static_cast<unsigned char>(*current) : EOF;
+
+                if (currentChar == '\n') {
+                    lineNumber++;
+                    output += currentChar;
                 }
-                if (currentChar == '/') {
-                    if (inFile.peek() == '/') {
-                        currentState = State::SINGLELINE;
-                        outFile << " ";
-                    }
-                    else if (inFile.peek() == '*') {
-                        currentState = State::MULTILINE;
-                        beginComment = lineNumber;
-                        outFile << " ";
-                    }
-                    else {
-                        outFile << currentChar;
+                else if (currentChar == '"') {
+                    currentState = CommentState::STRING;
+                    output += currentChar;
+                }
+                else if (currentChar == '*') {
+                    if (nextChar == '/') {
+                        unterminatedComment(lineNumber);
                     }
+                    output += currentChar;
+                }
+                else if (nextChar == '/') {
+                    currentState = CommentState::SINGLELINE;
+                    output += ' ';
+                }
+                else if (nextChar == '*') {
+                    currentState = CommentState::MULTILINE;
+                    beginComment = lineNumber;
+                    output += ' ';
                 }
                 else {
-                    outFile << currentChar;
+                    output += currentChar;
                 }
                 break;
 
-            case State::SINGLELINE:
-                outFile << " ";
-                if (currentChar == '\n') {
-                    outFile << "\n";
-                    currentState = State::START;
+            case CommentState::SINGLELINE:
+                // blank the rest of the line
+                next = CharScan::findAny(current, end, '\n', '\n', '\n', '\n');
+                output.append(next - current, ' ');
+                current = next;
+                if (current != end) {
+                    current++;
+                    lineNumber++;
+                    output += " \n";
+                    currentState = CommentState::START;
                 }
                 break;
 
-            case State::MULTILINE:
-                outFile << " ";
-                if (currentChar == '\n') {
-                    outFile << "\n";
-                }
-
-                if (currentChar == '*' && inFile.peek() == '/') {
-                    currentState = State::START;
-                    inFile.ignore(); // skip the / that we found
-                    outFile << " "; // output a space for / that we skipped
+            case CommentState::MULTILINE:
+                // blank everything up to a newline or a possible */
+                next = CharScan::findAny(current, end, '*', '\n', '*', '\n');
+                output.append(next - current, ' ');
+                current = next;
+                if (current != end) {
+                    currentChar = *current++;
+                    nextChar = (current != end) ? static_cast<unsigned char>(*current) : EOF;
+
+                    output += ' ';
+                    if (currentChar == '\n') {
+                        lineNumber++;
+                        output += '\n';
+                    }
+                    else if (nextChar == '/') {
+                        currentState = CommentState::START;
+                        current++; // skip the / that we found
+                        output += ' '; // output a space for / that we skipped
+                    }
                 }
 
-                if (inFile.peek() == EOF) {
-                    std::cout << "ERROR: Program contains C - style, unterminated comment on line " 
-                              << beginComment << std::endl;
+                if (current == end) {
+                    unterminatedComment(beginComment);
                 }
                 break;
 
-            case State::STRING:
-                outFile << currentChar;
-                if (currentChar == '"') {
-                    currentState = State::START;
+            case CommentState::STRING:
+                // copy the string up to its closing quote
+                next = CharScan::findAny(current, end, '"', '\n', '"', '\n');
+                output.append(current, next);
+                current = next;
+                if (current != end) {
+                    currentChar = *current++;
+                    output += currentChar;
+                    if (currentChar == '\n') {
+                        lineNumber++;
+                    }
+                    else {
+                        currentState = CommentState::START;
+                    }
                 }
                 break;
         }
     }
-
-    inFile.close();
-    outFile.close();
 }
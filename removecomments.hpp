@@ -5,19 +5,231 @@
     RemoveComments header file
     Description: The RemoveComments class contains a function that will 
     remove comments from a .c file and output a .c file with the comments 
-    replaced with whitespace.
+    replaced with whitespace. The comments can also be removed from a
+    source buffer in memory so no intermediate file is needed, or
+    skipped while the source is read with a CommentSkipper.
 */
 
 #ifndef REMOVE_COMMENTS_HPP
 #define REMOVE_COMMENTS_HPP
 
+#include <cstddef>
+#include <cstdio>
 #include <string>
+#include <vector>
+
+/*
+    States to determine what type of comment is being read.
+*/
+enum class CommentState {
+    START,
+    SINGLELINE,
+    MULTILINE,
+    STRING
+};
 
 class RemoveComments {
     public:
-        // member function
+        // member functions
         static void removeComments(const std::string &inputFilename, 
                                    const std::string &outputFilename);
+        static std::string removeCommentsFromSource(const std::string &source);
+        static void removeComments(const char* begin, const char* end,
+                                   std::string &output);
+        static void unterminatedComment(int lineNumber);
+};
+
+/*
+    The CommentSkipper class reads a source with its comments replaced
+    with whitespace, one character at a time, without making a copy.
+    The source is read from a SourceReader or a SourceStream, and the
+    CommentSkipper has the same get, peek and putback calls so the
+    tokenizer can read from it directly.
+*/
+template <typename Reader>
+class CommentSkipper {
+    public:
+        // firstLine is the line of the source's first character
+        explicit CommentSkipper(Reader &source, int firstLine = 1) :
+            source(source), currentState(CommentState::START),
+            lineNumber(firstLine), beginComment(0), pendingChar('\0'),
+            pendingPosition(0), lastChar('\0'), lastPosition(0),
+            lookaheadCount(0), errorLines(nullptr) {}
+
+        bool get(char &currentChar) {
+            if (lookaheadCount > 0) {
+                lookaheadCount--;
+                lastChar = lookahead[lookaheadCount];
+                lastPosition = lookaheadPosition[lookaheadCount];
+            }
+            else if (!read(lastChar, lastPosition)) {
+                return false;
+            }
+            currentChar = lastChar;
+            return true;
+        }
+        int peek() {
+            if (lookaheadCount == 0) {
+                if (!read(lookahead[0], lookaheadPosition[0])) {
+                    return EOF;
+                }
+                lookaheadCount = 1;
+            }
+            return static_cast<unsigned char>(lookahead[lookaheadCount - 1]);
+        }
+        void putback() {
+            lookahead[lookaheadCount] = lastChar;
+            lookaheadPosition[lookaheadCount] = lastPosition;
+            lookaheadCount++;
+        }
+        // offset in the source of the character the next get returns,
+        // a character written for a comment has the comment's offset
+        std::size_t position() const {
+            if (lookaheadCount > 0) {
+                return lookaheadPosition[lookaheadCount - 1];
+            }
+            if (pendingChar != '\0') {
+                return pendingPosition;
+            }
+            return source.position();
+        }
+        // number of newlines read from the source
+        std::size_t newlineCount() const {
+            return source.newlineCount();
+        }
+
+        /*
+            This function makes the CommentSkipper add the line numbers
+            of unterminated comments to lines instead of printing them.
+        */
+        void recordErrors(std::vector<int> *lines) {
+            errorLines = lines;
+        }
+
+        // true if nothing has been read ahead and no comment or string is open
+        bool atStart() const {
+            return currentState == CommentState::START && pendingChar == '\0' &&
+                   lookaheadCount == 0;
+        }
+
+        /*
+            This function reads the rest of the source so errors for
+            comments after the point where the reader stopped are
+            still reported.
+        */
+        void finish() {
+            char currentChar;
+            while (get(currentChar)) {
+            }
+        }
+
+    private:
+        bool read(char &currentChar, std::size_t &charPosition) {
+            if (pendingChar != '\0') {
+                currentChar = pendingChar;
+                charPosition = pendingPosition;
+                pendingChar = '\0';
+                return true;
+            }
+            charPosition = source.position();
+            return nextChar(currentChar);
+        }
+
+        /*
+            This function reads the next raw character of the source and
+            returns the first character RemoveComments would write for
+            it. A second character (the newline after a comment, or the
+            space for the / of a closing comment) is kept in pendingChar.
+        */
+        bool nextChar(char &outputChar) {
+            char currentChar;
+            if (!source.get(currentChar)) {
+                return false;
+            }
+            int followingChar = source.peek();
+
+            if (currentChar == '\n') {
+                lineNumber++;
+            }
+            outputChar = ' ';
+            switch (currentState) {
+                // State for anything not in a comment
+                case CommentState::START:
+                    if (currentChar == '"') {
+                        currentState = CommentState::STRING;
+                    }
+                    else if (currentChar == '*' && followingChar == '/') {
+                        unterminatedComment(lineNumber);
+                    }
+                    else if (currentChar == '/' && followingChar == '/') {
+                        currentState = CommentState::SINGLELINE;
+                        return true;
+                    }
+                    else if (currentChar == '/' && followingChar == '*') {
+                        currentState = CommentState::MULTILINE;
+                        beginComment = lineNumber;
+                        return true;
+                    }
+                    outputChar = currentChar;
+                    break;
+
+                case CommentState::SINGLELINE:
+                    if (currentChar == '\n') {
+                        pendingChar = '\n';
+                        pendingPosition = source.position() - 1;
+                        currentState = CommentState::START;
+                    }
+                    break;
+
+                case CommentState::MULTILINE:
+                    if (currentChar == '\n') {
+                        pendingChar = '\n';
+                        pendingPosition = source.position() - 1;
+                    }
+                    else if (currentChar == '*' && followingChar == '/') {
+                        currentState = CommentState::START;
+                        pendingPosition = source.position();
+                        source.get(currentChar); // skip the / that we found
+                        pendingChar = ' '; // output a space for / that we skipped
+                    }
+
+                    if (source.peek() == EOF) {
+                        unterminatedComment(beginComment);
+                    }
+                    break;
+
+                case CommentState::STRING:
+                    if (currentChar == '"') {
+                        currentState = CommentState::START;
+                    }
+                    outputChar = currentChar;
+                    break;
+            }
+            return true;
+        }
+
+        void unterminatedComment(int commentLine) {
+            if (errorLines) {
+                errorLines->push_back(commentLine);
+            }
+            else {
+                RemoveComments::unterminatedComment(commentLine);
+            }
+        }
+
+        Reader &source;
+        CommentState currentState;
+        int lineNumber;
+        int beginComment;
+        char pendingChar;
+        std::size_t pendingPosition;
+        // characters that were peeked or put back, read last in first out
+        char lookahead[2];
+        std::size_t lookaheadPosition[2];
+        char lastChar;
+        std::size_t lastPosition;
+        int lookaheadCount;
+        std::vector<int> *errorLines;
 };
 
 #endif
@@ -0,0 +1,364 @@
+/*
+    Implementation of the ReportWriter class
+    by: Kathy
+
+    Description: This file contains the implementation of the
+    ReportWriter class functions declared in the header file.
+*/
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "reportwriter.hpp"
+
+const std::size_t ReportWriter::blockSize;
+
+namespace {
+
+const char binaryMagic[8] = {'R', 'E', 'P', 'O', 'R', 'T', 1, 0};
+
+/*
+    The tags that start the entries of the binary format.
+*/
+enum BinaryTag {
+    KEY_TAG = 1,
+    RECORD_TAG,
+    STRING_TAG,
+    INTEGER_TAG,
+    BOOLEAN_TAG,
+    END_TAG
+};
+
+}
+
+/*
+    The constructor creates the output file, or empties it if it
+    exists. If it can't be created, nothing is written and good
+    returns false.
+*/
+ReportWriter::ReportWriter(const std::string &outputFilename, ReportFormat format) :
+    outputFormat(format), failed(false), firstField(true) {
+    descriptor = ::open(outputFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    buffer.reserve(blockSize + blockSize / 4);
+    startFile();
+}
+
+/*
+    The destructor writes what is left in the buffer and closes the
+    file.
+*/
+ReportWriter::~ReportWriter() {
+    if (descriptor >= 0) {
+        flush();
+        ::close(descriptor);
+    }
+}
+
+/*
+    This function writes a string of text.
+*/
+ReportWriter& ReportWriter::operator<<(const char* text) {
+    write(text, std::strlen(text));
+    return *this;
+}
+
+/*
+    This function writes one character.
+*/
+ReportWriter& ReportWriter::operator<<(char character) {
+    buffer.push_back(character);
+    if (buffer.size() >= blockSize) {
+        flush();
+    }
+    return *this;
+}
+
+/*
+    This function writes length bytes at data. The buffer is written
+    to the file whenever it holds a block.
+*/
+void ReportWriter::write(const char* data, std::size_t length) {
+    buffer.append(data, length);
+    if (buffer.size() >= blockSize) {
+        flush();
+    }
+}
+
+/*
+    This function writes a number in decimal.
+*/
+void ReportWriter::writeInteger(long long number) {
+    char digits[24];
+    char* end = digits + sizeof(digits);
+    char* first = end;
+    unsigned long long magnitude = number < 0 ? 0ULL - static_cast<unsigned long long>(number) :
+                                                static_cast<unsigned long long>(number);
+    do {
+        *--first = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (number < 0) {
+        *--first = '-';
+    }
+    write(first, end - first);
+}
+
+/*
+    This function writes a number in the varint form of the binary
+    format.
+*/
+void ReportWriter::writeVarint(unsigned long long number) {
+    char bytes[10];
+    std::size_t length = 0;
+    while (number >= 0x80) {
+        bytes[length++] = static_cast<char>((number & 0x7F) | 0x80);
+        number >>= 7;
+    }
+    bytes[length++] = static_cast<char>(number);
+    write(bytes, length);
+}
+
+/*
+    This function writes a string in quotes with the characters that
+    JSON doesn't allow in a string escaped.
+*/
+void ReportWriter::writeJsonString(const char* data, std::size_t length) {
+    static const char hexDigits[] = "0123456789abcdef";
+    buffer.push_back('"');
+
+    // the characters that need no escape are copied in runs
+    std::size_t runStart = 0;
+    for (std::size_t i = 0; i < length; i++) {
+        unsigned char character = static_cast<unsigned char>(data[i]);
+        if (character >= 0x20 && character != '"' && character != '\\') {
+            continue;
+        }
+        buffer.append(data + runStart, i - runStart);
+        runStart = i + 1;
+
+        switch (character) {
+            case '"': buffer.append("\\\""); break;
+            case '\\': buffer.append("\\\\"); break;
+            case '\n': buffer.append("\\n"); break;
+            case '\r': buffer.append("\\r"); break;
+            case '\t': buffer.append("\\t"); break;
+            default: {
+                char escape[6] = {'\\', 'u', '0', '0', hexDigits[character >> 4], hexDigits[character & 0xF]};
+                buffer.append(escape, sizeof(escape));
+                break;
+            }
+        }
+    }
+    buffer.append(data + runStart, length - runStart);
+    buffer.push_back('"');
+}
+
+/*
+    This function starts a record of a type, which is written as a
+    field named type in JSON.
+*/
+void ReportWriter::beginRecord(const char* type) {
+    if (outputFormat == ReportFormat::JSON_LINES) {
+        buffer.push_back('{');
+        firstField = true;
+        field("type", type, std::strlen(type));
+    }
+    else if (outputFormat == ReportFormat::BINARY) {
+        std::size_t typeKey = key(type);
+        buffer.push_back(static_cast<char>(RECORD_TAG));
+        writeVarint(typeKey);
+    }
+}
+
+/*
+    This function writes the name of a field, and for the binary
+    format the tag of its value.
+*/
+void ReportWriter::beginField(const char* name, char tag) {
+    if (outputFormat == ReportFormat::JSON_LINES) {
+        if (!firstField) {
+            buffer.push_back(',');
+        }
+        firstField = false;
+        writeJsonString(name, std::strlen(name));
+        buffer.push_back(':');
+    }
+    else {
+        std::size_t nameKey = key(name);
+        buffer.push_back(tag);
+        writeVarint(nameKey);
+    }
+}
+
+/*
+    This function writes a field whose value is a string.
+*/
+void ReportWriter::field(const char* name, const char* value, std::size_t length) {
+    if (outputFormat == ReportFormat::TEXT) {
+        return;
+    }
+    beginField(name, static_cast<char>(STRING_TAG));
+    if (outputFormat == ReportFormat::JSON_LINES) {
+        writeJsonString(value, length);
+    }
+    else {
+        writeVarint(length);
+        buffer.append(value, length);
+    }
+}
+
+/*
+    This function writes a field whose value is an integer.
+*/
+void ReportWriter::field(const char* name, long long value) {
+    if (outputFormat == ReportFormat::TEXT) {
+        return;
+    }
+    beginField(name, static_cast<char>(INTEGER_TAG));
+    if (outputFormat == ReportFormat::JSON_LINES) {
+        writeInteger(value);
+    }
+    else {
+        unsigned long long zigzag = (static_cast<unsigned long long>(value) << 1) ^
+                                    static_cast<unsigned long long>(value >> 63);
+        writeVarint(zigzag);
+    }
+}
+
+/*
+    This function writes a field whose value is true or false.
+*/
+void ReportWriter::field(const char* name, bool value) {
+    if (outputFormat == ReportFormat::TEXT) {
+        return;
+    }
+    beginField(name, static_cast<char>(BOOLEAN_TAG));
+    if (outputFormat == ReportFormat::JSON_LINES) {
+        buffer.append(value ? "true" : "false");
+    }
+    else {
+        buffer.push_back(value ? 1 : 0);
+    }
+}
+
+/*
+    This function ends a record, which is a line of its own in JSON.
+*/
+void ReportWriter::endRecord() {
+    if (outputFormat == ReportFormat::JSON_LINES) {
+        buffer.append("}\n");
+    }
+    else if (outputFormat == ReportFormat::BINARY) {
+        buffer.push_back(static_cast<char>(END_TAG));
+    }
+    if (buffer.size() >= blockSize) {
+        flush();
+    }
+}
+
+/*
+    This function returns the key number of a name in the binary
+    format, and defines the name first if it is new. There are few
+    names, so they are searched one after another.
+*/
+std::size_t ReportWriter::key(const char* name) {
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        if (keys[i] == name) {
+            return i;
+        }
+    }
+
+    std::size_t length = std::strlen(name);
+    buffer.push_back(static_cast<char>(KEY_TAG));
+    writeVarint(length);
+    buffer.append(name, length);
+    keys.push_back(std::string(name, length));
+    return keys.size() - 1;
+}
+
+/*
+    This function writes everything in the buffer to the file. Returns
+    false if the file couldn't be written, after which nothing more
+    is written.
+*/
+bool ReportWriter::flush() {
+    if (descriptor < 0 || failed) {
+        buffer.clear();
+        return false;
+    }
+
+    const char* data = buffer.data();
+    std::size_t remaining = buffer.size();
+    while (remaining > 0) {
+        ssize_t written = ::write(descriptor, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            failed = true;
+            break;
+        }
+        data += written;
+        remaining -= written;
+    }
+    buffer.clear();
+    return !failed;
+}
+
+/*
+    This function throws away everything written so far, so the file
+    can be written again from the start.
+*/
+void ReportWriter::restart() {
+    buffer.clear();
+    keys.clear();
+    if (descriptor >= 0 && !failed) {
+        if (::ftruncate(descriptor, 0) != 0 || ::lseek(descriptor, 0, SEEK_SET) != 0) {
+            failed = true;
+        }
+    }
+    startFile();
+}
+
+/*
+    This function writes what comes at the start of every file of the
+    format.
+*/
+void ReportWriter::startFile() {
+    if (outputFormat == ReportFormat::BINARY) {
+        buffer.append(binaryMagic, sizeof(binaryMagic));
+    }
+}
+
+/*
+    This function sets format to the format named text, jsonl or
+    binary. Returns false if the name isn't one of them.
+*/
+bool ReportWriter::parseFormat(const std::string &name, ReportFormat &format) {
+    if (name == "text") {
+        format = ReportFormat::TEXT;
+    }
+    else if (name == "jsonl") {
+        format = ReportFormat::JSON_LINES;
+    }
+    else if (name == "binary") {
+        format = ReportFormat::BINARY;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+/*
+    This function returns the file name extension of a format.
+*/
+const char* ReportWriter::extension(ReportFormat format) {
+    switch (format) {
+        case ReportFormat::JSON_LINES: return ".jsonl";
+        case ReportFormat::BINARY: return ".bin";
+        default: return ".txt";
+    }
+}
@@ -0,0 +1,99 @@
+/*
+    ReportWriter header file
+    by: Kathy
+
+    Description: The ReportWriter class writes the output files of the
+    program. Everything written is kept in a large buffer that is
+    written to the file a block at a time, instead of a line at a time.
+    A report is either the text that has always been written, or
+    records of named fields as JSON Lines or in a compact binary
+    format.
+
+    The binary format starts with the 8 bytes "REPORT" 1 0 and then
+    has entries that each start with a tag byte. Numbers are varints,
+    7 bits a byte with the high bit set on all but the last byte, and
+    integers are zigzag encoded first so small negative ones are
+    short too.
+        1 KEY      length, name; defines the next key number, from 0
+        2 RECORD   key of the record type; starts a record
+        3 STRING   key, length, bytes
+        4 INTEGER  key, value
+        5 BOOLEAN  key, one byte 0 or 1
+        6 END      ends the record
+*/
+
+#ifndef REPORT_WRITER_HPP
+#define REPORT_WRITER_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+enum class ReportFormat : unsigned char {
+    TEXT,
+    JSON_LINES,
+    BINARY
+};
+
+class ReportWriter {
+    public:
+        // constructor and destructor
+        explicit ReportWriter(const std::string &outputFilename,
+                              ReportFormat format = ReportFormat::TEXT);
+        ~ReportWriter();
+
+        // member functions for text
+        ReportWriter& operator<<(const char* text);
+        ReportWriter& operator<<(const std::string &text) { write(text.data(), text.size()); return *this; }
+        ReportWriter& operator<<(char character);
+        ReportWriter& operator<<(int number) { writeInteger(number); return *this; }
+        ReportWriter& operator<<(unsigned int number) { writeInteger(number); return *this; }
+        ReportWriter& operator<<(long long number) { writeInteger(number); return *this; }
+        void write(const char* data, std::size_t length);
+
+        // member functions for records
+        void beginRecord(const char* type);
+        void field(const char* name, const char* value, std::size_t length);
+        void field(const char* name, const std::string &value) { field(name, value.data(), value.size()); }
+        void field(const char* name, long long value);
+        void field(const char* name, int value) { field(name, static_cast<long long>(value)); }
+        void field(const char* name, unsigned int value) { field(name, static_cast<long long>(value)); }
+        void field(const char* name, bool value);
+        void endRecord();
+
+        // member functions for the file
+        ReportFormat format() const { return outputFormat; }
+        bool isText() const { return outputFormat == ReportFormat::TEXT; }
+        bool good() const { return descriptor >= 0 && !failed; }
+        bool flush();
+        void restart();
+        static bool parseFormat(const std::string &name, ReportFormat &format);
+        static const char* extension(ReportFormat format);
+
+        // size of the blocks the buffer is written in
+        static const std::size_t blockSize = 1 << 20;
+
+    private:
+        // copying would write the buffer twice
+        ReportWriter(const ReportWriter&);
+        ReportWriter& operator=(const ReportWriter&);
+
+        void writeInteger(long long number);
+        void writeVarint(unsigned long long number);
+        void writeJsonString(const char* data, std::size_t length);
+        void beginField(const char* name, char tag);
+        std::size_t key(const char* name);
+        void startFile();
+
+        int descriptor;
+        ReportFormat outputFormat;
+        bool failed;
+        // true until the first field of a JSON record is written
+        bool firstField;
+        // what has been written but isn't in the file yet
+        std::string buffer;
+        // names of the binary keys so far, by key number
+        std::vector<std::string> keys;
+};
+
+#endif
@@ -0,0 +1,475 @@
+/*
+    Self test file
+    by: Kathy
+
+    Description: This file contains a main function that checks parts
+    of the program that have two ways of getting the same answer, on
+    generated inputs: the plain, SSE2 and AVX2 versions of CharScan and
+    of removing comments, the tokens after an edit and the tokens of the
+    edited source tokenized from the start, the tokens of a source
+    tokenized in segments on threads and from the start, and the
+    symbol table read on one thread and on several. It also reads
+    sources that end in the middle of a declaration. It prints each
+    check that fails and returns 1 if any did. It is run with make test.
+*/
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "charscan.hpp"
+#include "removecomments.hpp"
+#include "tokenization.hpp"
+#include "concretesyntaxtree.hpp"
+#include "symboltable.hpp"
+
+// number of checks that failed
+static int failures = 0;
+
+/*
+    This function prints a check that failed.
+*/
+static void fail(const std::string &check, const std::string &detail) {
+    std::cout << "FAILED " << check << ": " << detail << std::endl;
+    failures++;
+}
+
+/*
+    This function returns the next number of a simple generator, so
+    the inputs are the same on every run.
+*/
+static unsigned int nextRandom(unsigned int &seed) {
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+/*
+    This function returns a source of length characters made mostly of
+    the characters that start and end comments and strings, so they
+    land on every side of the 16 and 32 byte blocks the vector
+    versions read.
+*/
+static std::string generateSource(unsigned int seed, std::size_t length) {
+    static const char characters[] = "/*\"\n/*\"\nab; \\x{}";
+    std::string source;
+    source.reserve(length);
+    for (std::size_t i = 0; i < length; i++) {
+        source.push_back(characters[nextRandom(seed) % (sizeof(characters) - 1)]);
+    }
+    return source;
+}
+
+/*
+    The output of the scans of one input, and of removing its
+    comments, with the unterminated comment messages printed.
+*/
+struct ScanResult {
+    std::vector<unsigned int> newlines;
+    std::vector<unsigned int> slashes;
+    std::size_t quoteCount;
+    // offset findAny returns from each start, for two sets of characters
+    std::vector<std::size_t> nextComment;
+    std::vector<std::size_t> nextStar;
+    std::string stripped;
+    std::string messages;
+};
+
+/*
+    This function scans the characters from begin to end with the
+    version of CharScan that is in use.
+*/
+static ScanResult scan(const char* begin, const char* end) {
+    ScanResult result;
+    CharScan::findAll(begin, end, '\n', result.newlines);
+    CharScan::findAll(begin, end, '/', result.slashes);
+    result.quoteCount = CharScan::count(begin, end, '"');
+    for (const char* start = begin; start <= end; start++) {
+        result.nextComment.push_back(CharScan::findAny(start, end, '/', '*', '"', '\n') - begin);
+        result.nextStar.push_back(CharScan::findAny(start, end, '*', '\n', '*', '\n') - begin);
+    }
+
+    // the messages for unterminated comments are part of the output
+    std::ostringstream messages;
+    std::streambuf* console = std::cout.rdbuf(messages.rdbuf());
+    RemoveComments::removeComments(begin, end, result.stripped);
+    std::cout.rdbuf(console);
+    result.messages = messages.str();
+    return result;
+}
+
+/*
+    This function checks that the SSE2 and AVX2 versions of CharScan,
+    and removing comments with them, give the same output as the plain
+    version for sources of every length up to 300 and some longer
+    ones, each placed at every alignment of a 32 byte block. A version
+    this CPU doesn't have is skipped.
+*/
+static void checkVectorScans() {
+    static const ScanLevel levels[] = {ScanLevel::SSE2, ScanLevel::AVX2};
+    static const char* const levelNames[] = {"SSE2", "AVX2"};
+    const std::size_t levelCount = sizeof(levels) / sizeof(levels[0]);
+    ScanLevel original = CharScan::level();
+
+    std::vector<bool> available(levelCount);
+    for (std::size_t level = 0; level < levelCount; level++) {
+        available[level] = CharScan::setLevel(levels[level]);
+        if (!available[level]) {
+            std::cout << "charscan: no " << levelNames[level]
+                      << " version on this CPU, it isn't checked" << std::endl;
+        }
+    }
+
+    std::vector<std::size_t> lengths;
+    for (std::size_t length = 0; length <= 300; length++) {
+        lengths.push_back(length);
+    }
+    lengths.push_back(1023);
+    lengths.push_back(4097);
+
+    int checked = 0;
+    for (std::size_t i = 0; i < lengths.size(); i++) {
+        std::string source = generateSource(static_cast<unsigned int>(i) + 1, lengths[i]);
+        for (std::size_t alignment = 0; alignment < 32; alignment++) {
+            // the source is copied to alignment bytes after a 32 byte boundary
+            std::vector<char> buffer(source.size() + 64);
+            std::size_t padding = (32 - reinterpret_cast<std::size_t>(&buffer[0]) % 32) % 32;
+            char* begin = &buffer[0] + padding + alignment;
+            source.copy(begin, source.size());
+            char* end = begin + source.size();
+
+            CharScan::setLevel(ScanLevel::SCALAR);
+            ScanResult plain = scan(begin, end);
+            for (std::size_t level = 0; level < levelCount; level++) {
+                if (!available[level]) {
+                    continue;
+                }
+                CharScan::setLevel(levels[level]);
+                ScanResult vector = scan(begin, end);
+                checked++;
+
+                std::ostringstream where;
+                where << levelNames[level] << ", length " << source.size()
+                      << ", alignment " << alignment;
+                if (plain.newlines != vector.newlines || plain.slashes != vector.slashes) {
+                    fail("charscan findAll", where.str());
+                }
+                if (plain.quoteCount != vector.quoteCount) {
+                    fail("charscan count", where.str());
+                }
+                if (plain.nextComment != vector.nextComment || plain.nextStar != vector.nextStar) {
+                    fail("charscan findAny", where.str());
+                }
+                if (plain.stripped != vector.stripped || plain.messages != vector.messages) {
+                    fail("removeComments", where.str());
+                }
+            }
+        }
+    }
+    CharScan::setLevel(original);
+    std::cout << "charscan: " << checked << " sources checked" << std::endl;
+}
+
+/*
+    This function returns a description of the first difference
+    between two token lists, or "" if they are the same: the kind,
+    place, line, value and integer value of each token, and the name of
+    its atom or that it has none.
+*/
+static std::string compareTokens(const Tokenization &edited, const Tokenization &fresh) {
+    std::ostringstream difference;
+    if (edited.tokenCount() != fresh.tokenCount()) {
+        difference << edited.tokenCount() << " tokens instead of " << fresh.tokenCount();
+        return difference.str();
+    }
+    for (std::size_t i = 0; i < fresh.tokenCount(); i++) {
+        const Token &editedToken = edited.tokenAt(i);
+        const Token &freshToken = fresh.tokenAt(i);
+        std::string editedAtom = (editedToken.atom == AtomTable::none) ? "(none)" :
+                                 edited.atomTable().name(editedToken.atom);
+        std::string freshAtom = (freshToken.atom == AtomTable::none) ? "(none)" :
+                                fresh.atomTable().name(freshToken.atom);
+        if (editedToken.kind != freshToken.kind ||
+            edited.location(editedToken) != fresh.location(freshToken) ||
+            edited.line(editedToken) != fresh.line(freshToken) ||
+            edited.value(editedToken) != fresh.value(freshToken) ||
+            editedToken.integerValue != freshToken.integerValue ||
+            editedAtom != freshAtom) {
+            difference << "token " << i << " \"" << edited.value(editedToken) << "\" with atom "
+                       << editedAtom << " instead of \"" << fresh.value(freshToken)
+                       << "\" with atom " << freshAtom;
+            return difference.str();
+        }
+    }
+    return "";
+}
+
+/*
+    This function checks that the tokens kept up to date by edit are
+    the same as the tokens of the edited source tokenized from the
+    start, atoms included. Each round makes random edits to copies of
+    a small program, with and without skipping comments.
+*/
+static void checkEdits() {
+    static const char program[] =
+        "/* sum of the first n squares */\n"
+        "char announcement[2048];\n"
+        "function int sum_of_squares (int n)\n"
+        "{\n"
+        "  int sum; // the total\n"
+        "  sum = n * (n + 1) * (2 * n + 1) / 6;\n"
+        "  if (n >= 1) { return sum; } else { return -1; }\n"
+        "}\n"
+        "procedure main (void)\n"
+        "{\n"
+        "  printf (\"sum = %d\\n\", sum_of_squares (10));\n"
+        "  letter = 'a'; flag = !(n <= 3) && n != -1;\n"
+        "}\n";
+    static const char* const insertions[] = {
+        "", " ", "x", "pr", "else", "42", "-", "=", ";", "(", "{", "\"", "'", "/*", "*/",
+        "//", "\n", "\t", "int y;\n", "\\"
+    };
+    const std::size_t insertionCount = sizeof(insertions) / sizeof(insertions[0]);
+
+    // the edits open comments that aren't closed, which are reported
+    std::ostringstream messages;
+    std::streambuf* console = std::cout.rdbuf(messages.rdbuf());
+
+    int edits = 0;
+    for (unsigned int round = 0; round < 20; round++) {
+        bool skipComments = (round % 2 == 0);
+        std::string source;
+        for (int copy = 0; copy < 30; copy++) {
+            source += program;
+        }
+
+        Tokenization edited;
+        if (skipComments) {
+            edited.tokenizeSkippingComments(source.data(), source.data() + source.size());
+        }
+        else {
+            edited.tokenize(source.data(), source.data() + source.size());
+        }
+
+        unsigned int seed = round + 1;
+        for (int i = 0; i < 50; i++) {
+            std::size_t offset = nextRandom(seed) % (source.size() + 1);
+            std::size_t removedLength = std::min<std::size_t>(nextRandom(seed) % 4, source.size() - offset);
+            std::string insertedText = insertions[nextRandom(seed) % insertionCount];
+            edited.edit(source, offset, removedLength, insertedText);
+            edits++;
+
+            std::string freshSource = source;
+            Tokenization fresh;
+            if (skipComments) {
+                fresh.tokenizeSkippingComments(freshSource.data(), freshSource.data() + freshSource.size());
+            }
+            else {
+                fresh.tokenize(freshSource.data(), freshSource.data() + freshSource.size());
+            }
+
+            std::string difference = compareTokens(edited, fresh);
+            if (!difference.empty()) {
+                std::ostringstream where;
+                where << "round " << round << ", edit " << i << ", offset " << offset << ": " << difference;
+                std::cout.rdbuf(console);
+                fail("tokenization edit", where.str());
+                std::cout.rdbuf(messages.rdbuf());
+                break;
+            }
+        }
+    }
+    std::cout.rdbuf(console);
+    std::cout << "tokenization: " << edits << " edits checked" << std::endl;
+}
+
+/*
+    This function checks that tokenizing a source in segments on 4
+    threads gives the same tokens, messages and error as tokenizing it
+    from the start, with and without skipping comments. The segments
+    are 1, 7 and 64 characters, so strings, comments and names cross
+    the places the segments are joined. The sources are generated ones
+    and copies of a small program whose lines start with tabs, which
+    repeat the token before them from the segment before.
+*/
+static void checkParallelTokenization() {
+    static const char program[] =
+        "/* squares */ int total; // the total\n"
+        "procedure main (void)\n"
+        "{\n"
+        "\ttotal = 3 * (total + 1); /* a comment\n"
+        "  over lines */ printf (\"total = %d\\n\", total);\n"
+        "\t letter = 'a'; flag = !(total <= 3) && total != -1;\t\n"
+        "}\n";
+    static const std::size_t segmentSizes[] = {1, 7, 64};
+
+    std::vector<std::string> sources;
+    for (unsigned int i = 0; i < 40; i++) {
+        sources.push_back(generateSource(i + 1000, 50 + 37 * i));
+    }
+    std::string copies;
+    for (int copy = 0; copy < 20; copy++) {
+        copies += program;
+        sources.push_back(copies);
+    }
+
+    int checked = 0;
+    for (std::size_t i = 0; i < sources.size(); i++) {
+        const char* begin = sources[i].data();
+        const char* end = begin + sources[i].size();
+        for (int skipComments = 0; skipComments <= 1; skipComments++) {
+            // the unterminated comment messages are part of the output
+            std::ostringstream freshMessages;
+            std::streambuf* console = std::cout.rdbuf(freshMessages.rdbuf());
+            Tokenization fresh;
+            if (skipComments) {
+                fresh.tokenizeSkippingComments(begin, end);
+            }
+            else {
+                fresh.tokenize(begin, end);
+            }
+            std::cout.rdbuf(console);
+
+            for (std::size_t size = 0; size < sizeof(segmentSizes) / sizeof(segmentSizes[0]); size++) {
+                std::ostringstream parallelMessages;
+                console = std::cout.rdbuf(parallelMessages.rdbuf());
+                Tokenization parallel;
+                parallel.tokenizeParallel(begin, end, skipComments != 0, 4, segmentSizes[size]);
+                std::cout.rdbuf(console);
+                checked++;
+
+                std::ostringstream where;
+                where << "source " << i << ", segments of " << segmentSizes[size]
+                      << (skipComments ? ", skipping comments" : "");
+                std::string difference = compareTokens(parallel, fresh);
+                if (!difference.empty()) {
+                    fail("tokenizeParallel", where.str() + ": " + difference);
+                }
+                if (parallel.hasInvalidToken() != fresh.hasInvalidToken() ||
+                    parallelMessages.str() != freshMessages.str()) {
+                    fail("tokenizeParallel error", where.str());
+                }
+            }
+        }
+    }
+    std::cout << "tokenization: " << checked << " parallel token lists checked" << std::endl;
+}
+
+/*
+    This function returns what the symbol table of a source read on
+    threadCount threads displays, which is its first error if it has
+    one.
+*/
+static std::string readSymbolTable(const std::string &source, unsigned int threadCount) {
+    Tokenization tokenizer;
+    tokenizer.tokenizeParallel(source.data(), source.data() + source.size(), true, 1);
+    ConcreteSyntaxTree cst;
+    cst.createCST(tokenizer);
+    SymbolTable symbolTable;
+    symbolTable.createSymbolTable(cst, threadCount);
+
+    const std::string outputFilename = "selftest-symbols.txt";
+    symbolTable.displaySymbolTable(outputFilename);
+    std::ifstream outputFile(outputFilename.c_str());
+    std::string output((std::istreambuf_iterator<char>(outputFile)), std::istreambuf_iterator<char>());
+    outputFile.close();
+    std::remove(outputFilename.c_str());
+    return output;
+}
+
+/*
+    This function checks that a symbol table read on several threads
+    is the same as one read on one thread, for a source where every
+    function declares a local twice, so the duplicates are reported on
+    the threads, and for one without duplicates. There are enough
+    functions for the threads to run at the same time, so a build with
+    -fsanitize=thread finds the threads sharing anything unlocked.
+*/
+static void checkThreadedSymbolTables() {
+    int checked = 0;
+    for (int duplicateEvery = 0; duplicateEvery <= 1; duplicateEvery++) {
+        std::ostringstream source;
+        source << "int total;\n";
+        for (int function = 0; function < 20000; function++) {
+            source << "function int f" << function << " (int value)\n{\n  int x;\n";
+            if (duplicateEvery > 0 && function % duplicateEvery == 0) {
+                source << "  char x;\n";
+            }
+            source << "  x = value;\n  return x;\n}\n";
+        }
+        source << "procedure main (void)\n{\n  total = f0 (1);\n}\n";
+
+        std::string serial = readSymbolTable(source.str(), 1);
+        for (unsigned int threadCount = 2; threadCount <= 8; threadCount *= 2) {
+            std::ostringstream where;
+            where << threadCount << " threads, " << (duplicateEvery > 0 ? "with" : "without")
+                  << " duplicates";
+            if (readSymbolTable(source.str(), threadCount) != serial) {
+                fail("symbol table threads", where.str());
+            }
+            checked++;
+        }
+        if (duplicateEvery > 0 && serial.find("is already defined locally") == std::string::npos) {
+            fail("symbol table duplicate", "the duplicate local isn't reported");
+        }
+    }
+    std::cout << "symbol table: " << checked << " threaded tables checked" << std::endl;
+}
+
+/*
+    This function checks that sources that end in the middle of a
+    declaration, or can't be tokenized, are read without reading past
+    the end of the tree, on one thread and on two, and that a
+    declaration that isn't complete is reported.
+*/
+static void checkTruncatedSources() {
+    static const char* const truncated[] = {
+        "int x[", "int a[3", "procedure main (void) { int", "int", "function int f (int",
+        "x", ";", "{", "}", "\"abc"
+    };
+    static const bool incomplete[] = {
+        true, true, true, true, true,
+        false, false, false, false, false
+    };
+    const std::size_t truncatedCount = sizeof(truncated) / sizeof(truncated[0]);
+
+    // the tokenizer prints the error of a string that isn't closed
+    std::ostringstream messages;
+    std::streambuf* console = std::cout.rdbuf(messages.rdbuf());
+    std::vector<std::string> outputs;
+    for (std::size_t i = 0; i < truncatedCount; i++) {
+        for (unsigned int threadCount = 1; threadCount <= 2; threadCount++) {
+            outputs.push_back(readSymbolTable(truncated[i], threadCount));
+        }
+    }
+    std::cout.rdbuf(console);
+
+    for (std::size_t i = 0; i < truncatedCount; i++) {
+        const std::string &serial = outputs[2 * i];
+        if (outputs[2 * i + 1] != serial) {
+            fail("truncated source threads", truncated[i]);
+        }
+        bool reported = (serial.find("the declaration is not complete") != std::string::npos);
+        if (reported != incomplete[i]) {
+            fail("truncated source", std::string(truncated[i]) + ": " + serial);
+        }
+    }
+    std::cout << "symbol table: " << truncatedCount << " truncated sources checked" << std::endl;
+}
+
+int main() {
+    checkVectorScans();
+    checkEdits();
+    checkParallelTokenization();
+    checkThreadedSymbolTables();
+    checkTruncatedSources();
+
+    if (failures > 0) {
+        std::cout << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all checks passed" << std::endl;
+    return 0;
+}
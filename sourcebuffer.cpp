@@ -0,0 +1,176 @@
+/*
+    Implementation of the SourceBuffer class
+    by: Kathy
+
+    Description: This file contains the implementation of the
+    SourceBuffer class functions declared in the header file.
+*/
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sourcebuffer.hpp"
+#include "charscan.hpp"
+
+/*
+    The default constructor starts with an empty buffer.
+*/
+SourceBuffer::SourceBuffer() {
+    data = "";
+    length = 0;
+    mapped = false;
+}
+
+/*
+    The destructor unmaps the file if it was mapped.
+*/
+SourceBuffer::~SourceBuffer() {
+    close();
+}
+
+/*
+    This function opens the input file and maps it read-only into
+    memory. If the file can't be mapped (for example a pipe), the
+    file is read into memory instead. Returns false if the file
+    can't be opened.
+*/
+bool SourceBuffer::open(const std::string &inputFilename) {
+    close();
+
+    int fileDescriptor = ::open(inputFilename.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+        return false;
+    }
+
+    struct stat fileStatus;
+    if (fstat(fileDescriptor, &fileStatus) == 0 && S_ISREG(fileStatus.st_mode) &&
+        fileStatus.st_size > 0) {
+        void* address = mmap(nullptr, fileStatus.st_size, PROT_READ, MAP_PRIVATE,
+                             fileDescriptor, 0);
+        if (address != MAP_FAILED) {
+            // the whole file is read front to back
+            madvise(address, fileStatus.st_size, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(address);
+            length = fileStatus.st_size;
+            mapped = true;
+            ::close(fileDescriptor);
+            return true;
+        }
+    }
+
+    // fall back to reading the file in blocks
+    char block[65536];
+    ssize_t bytesRead;
+    while ((bytesRead = read(fileDescriptor, block, sizeof(block))) > 0) {
+        fallback.append(block, bytesRead);
+    }
+    ::close(fileDescriptor);
+
+    if (bytesRead < 0) {
+        fallback.clear();
+        return false;
+    }
+
+    data = fallback.data();
+    length = fallback.size();
+    return true;
+}
+
+/*
+    This function releases the mapping or the fallback copy.
+*/
+void SourceBuffer::close() {
+    if (mapped) {
+        munmap(const_cast<char*>(data), length);
+    }
+    fallback.clear();
+    data = "";
+    length = 0;
+    mapped = false;
+}
+
+/*
+    The SourceStream constructor sets the size of the chunks that are
+    read from the file. One extra character is kept so the last
+    character of the previous chunk can still be put back.
+*/
+SourceStream::SourceStream(std::size_t chunkSize) : buffer(chunkSize + 1) {
+    fileDescriptor = -1;
+    bufferOffset = 0;
+    newlinesBeforeBuffer = 0;
+    bufferPosition = 0;
+    length = 0;
+}
+
+/*
+    The destructor closes the file if it is still open.
+*/
+SourceStream::~SourceStream() {
+    close();
+}
+
+/*
+    This function opens the input file for reading. Returns false if
+    the file can't be opened.
+*/
+bool SourceStream::open(const std::string &inputFilename) {
+    close();
+    fileDescriptor = ::open(inputFilename.c_str(), O_RDONLY);
+    if (fileDescriptor >= 0) {
+        posix_fadvise(fileDescriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    return fileDescriptor >= 0;
+}
+
+/*
+    This function closes the file.
+*/
+void SourceStream::close() {
+    if (fileDescriptor >= 0) {
+        ::close(fileDescriptor);
+    }
+    fileDescriptor = -1;
+    bufferOffset = 0;
+    newlinesBeforeBuffer = 0;
+    bufferPosition = 0;
+    length = 0;
+}
+
+/*
+    This function reads the next chunk of the file into the buffer
+    after the last character of the previous chunk. Returns false at
+    the end of the file.
+*/
+bool SourceStream::refill() {
+    if (fileDescriptor < 0) {
+        return false;
+    }
+
+    // keep the last character so it can still be put back
+    std::size_t kept = 0;
+    if (length > 0) {
+        newlinesBeforeBuffer += CharScan::count(&buffer[0], &buffer[length - 1], '\n');
+        buffer[0] = buffer[length - 1];
+        bufferOffset += length - 1;
+        kept = 1;
+    }
+    bufferPosition = kept;
+    length = kept;
+
+    ssize_t bytesRead;
+    do {
+        bytesRead = read(fileDescriptor, &buffer[kept], buffer.size() - kept);
+    } while (bytesRead < 0 && errno == EINTR);
+
+    if (bytesRead <= 0) {
+        ::close(fileDescriptor);
+        fileDescriptor = -1;
+        return false;
+    }
+
+    length += bytesRead;
+    return true;
+}
@@ -0,0 +1,147 @@
+/*
+    SourceBuffer header file
+    by: Kathy
+
+    Description: The SourceBuffer class gives read-only access to
+    the contents of a .c file as one contiguous range of characters.
+    The file is memory mapped when possible, otherwise it is read
+    into memory with a plain read. The SourceReader and SourceStream
+    classes read characters from a range in memory or from a file
+    a fixed-size chunk at a time.
+*/
+
+#ifndef SOURCE_BUFFER_HPP
+#define SOURCE_BUFFER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class SourceBuffer {
+    public:
+        // default constructor and destructor
+        SourceBuffer();
+        ~SourceBuffer();
+
+        // member functions
+        bool open(const std::string &inputFilename);
+        void close();
+        const char* begin() const { return data; }
+        const char* end() const { return data + length; }
+        std::size_t size() const { return length; }
+
+    private:
+        // a mapped file can't be copied
+        SourceBuffer(const SourceBuffer&);
+        SourceBuffer& operator=(const SourceBuffer&);
+
+        const char* data;
+        std::size_t length;
+        bool mapped;
+        std::string fallback;
+};
+
+/*
+    The SourceReader class reads characters from a range in memory
+    with the same get, peek and putback calls as an input stream.
+*/
+class SourceReader {
+    public:
+        SourceReader(const char* begin, const char* end) :
+            begin(begin), current(begin), end(end) {}
+        // start reading at start, positions are still counted from begin
+        SourceReader(const char* begin, const char* start, const char* end) :
+            begin(begin), current(start), end(end) {}
+
+        bool get(char &currentChar) {
+            if (current == end) {
+                return false;
+            }
+            currentChar = *current++;
+            return true;
+        }
+        int peek() const {
+            return (current != end) ? static_cast<unsigned char>(*current) : EOF;
+        }
+        void putback() {
+            current--;
+        }
+        // offset of the character the next get returns
+        std::size_t position() const {
+            return current - begin;
+        }
+        // number of newlines before position
+        std::size_t newlineCount() const {
+            return std::count(begin, current, '\n');
+        }
+        // nothing is ever read ahead
+        bool atStart() const {
+            return true;
+        }
+
+    private:
+        const char* begin;
+        const char* current;
+        const char* end;
+};
+
+/*
+    The SourceStream class reads characters from a file with the same
+    calls as SourceReader, but only keeps one chunk of the file in
+    memory at a time, so files of any size can be read.
+*/
+class SourceStream {
+    public:
+        // constructor and destructor
+        explicit SourceStream(std::size_t chunkSize = 65536);
+        ~SourceStream();
+
+        // member functions
+        bool open(const std::string &inputFilename);
+        void close();
+
+        bool get(char &currentChar) {
+            if (bufferPosition == length && !refill()) {
+                return false;
+            }
+            currentChar = buffer[bufferPosition++];
+            return true;
+        }
+        int peek() {
+            if (bufferPosition == length && !refill()) {
+                return EOF;
+            }
+            return static_cast<unsigned char>(buffer[bufferPosition]);
+        }
+        void putback() {
+            bufferPosition--;
+        }
+        // offset in the file of the character the next get returns
+        std::size_t position() const {
+            return bufferOffset + bufferPosition;
+        }
+        // number of newlines before position
+        std::size_t newlineCount() const {
+            return newlinesBeforeBuffer +
+                   std::count(buffer.begin(), buffer.begin() + bufferPosition, '\n');
+        }
+
+    private:
+        // a file descriptor can't be copied
+        SourceStream(const SourceStream&);
+        SourceStream& operator=(const SourceStream&);
+
+        bool refill();
+
+        int fileDescriptor;
+        std::vector<char> buffer;
+        // offset in the file of buffer[0], and the newlines before it
+        std::size_t bufferOffset;
+        std::size_t newlinesBeforeBuffer;
+        std::size_t bufferPosition;
+        std::size_t length;
+};
+
+#endif
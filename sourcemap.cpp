@@ -0,0 +1,132 @@
+/*
+    Implementation of the SourceMap class
+    by: Kathy
+
+    Description: This file contains the implementation of the
+    SourceMap class functions declared in the header file.
+*/
+
+#include <algorithm>
+
+#include "sourcemap.hpp"
+#include "charscan.hpp"
+
+/*
+    The default constructor starts with no source.
+*/
+SourceMap::SourceMap() : begin(nullptr), end(nullptr), indexed(false) {
+}
+
+/*
+    This function starts mapping the source from begin to end, and
+    forgets the source that was mapped before.
+*/
+void SourceMap::reset(const char* sourceBegin, const char* sourceEnd) {
+    begin = sourceBegin;
+    end = sourceEnd;
+    newlines.clear();
+    indexed = false;
+    skippedNewlines.clear();
+}
+
+/*
+    This function moves the map to the edited source from begin to end,
+    where removedLength characters at offset were replaced with
+    insertedLength characters. Only the newlines of the inserted text
+    are looked for, the ones after it are moved. Newlines that aren't
+    counted are moved the same way, see replaceSkipped.
+*/
+void SourceMap::edit(const char* sourceBegin, const char* sourceEnd, std::size_t offset,
+                     std::size_t removedLength, std::size_t insertedLength) {
+    begin = sourceBegin;
+    end = sourceEnd;
+    std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(insertedLength) -
+                           static_cast<std::ptrdiff_t>(removedLength);
+
+    // the newlines of the inserted text, from offset
+    std::vector<unsigned int> insertedNewlines;
+    if (indexed) {
+        CharScan::findAll(begin + offset, begin + offset + insertedLength, '\n', insertedNewlines);
+        for (std::size_t i = 0; i < insertedNewlines.size(); i++) {
+            insertedNewlines[i] += offset;
+        }
+    }
+
+    std::vector<unsigned int>* lists[2] = {&newlines, &skippedNewlines};
+    for (int list = 0; list < 2; list++) {
+        std::vector<unsigned int> &offsets = *lists[list];
+        std::vector<unsigned int>::iterator first =
+            std::lower_bound(offsets.begin(), offsets.end(), offset);
+        std::vector<unsigned int>::iterator last =
+            std::lower_bound(first, offsets.end(), offset + removedLength);
+        for (std::vector<unsigned int>::iterator moved = last; moved != offsets.end(); ++moved) {
+            *moved = static_cast<unsigned int>(*moved + delta);
+        }
+        first = offsets.erase(first, last);
+        if (list == 0) {
+            offsets.insert(first, insertedNewlines.begin(), insertedNewlines.end());
+        }
+    }
+}
+
+/*
+    This function replaces the newlines that aren't counted from from
+    up to to with the ones of other, which were all found there.
+*/
+void SourceMap::replaceSkipped(std::size_t from, std::size_t to, const SourceMap &other) {
+    std::vector<unsigned int>::iterator first =
+        std::lower_bound(skippedNewlines.begin(), skippedNewlines.end(), from);
+    std::vector<unsigned int>::iterator last =
+        std::lower_bound(first, skippedNewlines.end(), to);
+    first = skippedNewlines.erase(first, last);
+    skippedNewlines.insert(first, other.skippedNewlines.begin(), other.skippedNewlines.end());
+}
+
+/*
+    This function returns the line of an offset in the source, which
+    is 1 plus the number of counted newlines before it.
+*/
+int SourceMap::line(std::size_t offset) const {
+    buildIndex();
+    std::size_t before = std::lower_bound(newlines.begin(), newlines.end(), offset) -
+                         newlines.begin();
+    std::size_t skipped = std::lower_bound(skippedNewlines.begin(), skippedNewlines.end(), offset) -
+                          skippedNewlines.begin();
+    return static_cast<int>(1 + before - skipped);
+}
+
+/*
+    This function returns the column of an offset in the source,
+    counting characters from 1 at the start of its line.
+*/
+int SourceMap::column(std::size_t offset) const {
+    buildIndex();
+    std::vector<unsigned int>::const_iterator next =
+        std::lower_bound(newlines.begin(), newlines.end(), offset);
+    if (next == newlines.begin()) {
+        return static_cast<int>(offset + 1);
+    }
+    return static_cast<int>(offset - *(next - 1));
+}
+
+/*
+    This function returns the number of newlines before an offset,
+    counted or not.
+*/
+std::size_t SourceMap::newlinesBefore(std::size_t offset) const {
+    buildIndex();
+    return std::lower_bound(newlines.begin(), newlines.end(), offset) - newlines.begin();
+}
+
+/*
+    This function finds the offsets of the newlines in the source,
+    the first time it is called. It isn't locked, so it is called
+    before threads share the map.
+*/
+void SourceMap::buildIndex() const {
+    if (indexed) {
+        return;
+    }
+    CharScan::findAll(begin, end, '\n', newlines);
+    indexed = true;
+}
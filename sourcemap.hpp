@@ -0,0 +1,54 @@
+/*
+    SourceMap header file
+    by: Kathy
+
+    Description: The SourceMap class finds the line and column of an
+    offset in a source. The offsets of the newlines in the source are
+    found with CharScan the first time a line is asked for, and each
+    lookup is a binary search of them. Newlines that the tokenizer
+    doesn't count (inside strings, or right after an escaped
+    character) are added with skipNewline so lines are numbered the
+    way the tokenizer always has. After an edit the newlines are
+    moved instead of being found again. The newlines are found without
+    a lock, so buildIndex has to be called before lines are asked for
+    on more than one thread.
+*/
+
+#ifndef SOURCE_MAP_HPP
+#define SOURCE_MAP_HPP
+
+#include <cstddef>
+#include <vector>
+
+class SourceMap {
+    public:
+        // default constructor
+        SourceMap();
+
+        // member functions
+        void reset(const char* begin, const char* end);
+        void edit(const char* begin, const char* end, std::size_t offset,
+                  std::size_t removedLength, std::size_t insertedLength);
+        void replaceSkipped(std::size_t from, std::size_t to, const SourceMap &other);
+        void skipNewline(std::size_t offset) { skippedNewlines.push_back(offset); }
+        std::size_t skippedCount() const { return skippedNewlines.size(); }
+        std::size_t skippedAt(std::size_t index) const { return skippedNewlines[index]; }
+        int line(std::size_t offset) const;
+        int column(std::size_t offset) const;
+        std::size_t newlinesBefore(std::size_t offset) const;
+        void buildIndex() const;
+
+        // declare friend class
+        friend class ConcreteSyntaxTree;
+
+    private:
+        const char* begin;
+        const char* end;
+        // offsets of the newlines in the source, found when first needed
+        mutable std::vector<unsigned int> newlines;
+        mutable bool indexed;
+        // offsets of the newlines that aren't counted, in order
+        std::vector<unsigned int> skippedNewlines;
+};
+
+#endif
@@ -5,58 +5,127 @@
     Decription: This file contains the implementations of the
     SymbolTable class functions declared in the header file.
 */
-#include <fstream>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <thread>
 
 #include "symboltable.hpp"
 
+const unsigned int SymbolTable::SymbolIndex::none;
+const unsigned int SymbolTable::globalScope;
+const unsigned int SymbolTable::noScope;
+const unsigned int Symbol::noSymbol;
+const unsigned int Symbol::noSlot;
+
 /*
     This is the default constructor for the SymbolTable class.
-    All pointers are initialized to nullptr and integers are set
-    to 0, while invalidSyntax is set to false.
+    All pointers are initialized to nullptr, the current CST node to
+    none and integers are set to 0, while invalidSyntax is set to false.
 */
 SymbolTable::SymbolTable() {
-    head = nullptr;
-    currentSymbol = nullptr;
-    currentCSTNode = nullptr;
-    size = 0;
+    tree = nullptr;
+    currentCSTNode = ConcreteSyntaxTree::none;
+    atoms = nullptr;
+    sourceMap = nullptr;
     invalidSyntax = false;
     errorLineNumber = 0;
+    errorSymbol = SymbolIndex::none;
+    currentScope = globalScope;
+    currentFunction = Symbol::noSymbol;
+    scopes.push_back(Scope(noScope, 0));
+    bindingBase = 0;
+    bindsGlobals = true;
+    incompleteDeclaration = false;
 }
 
 /*
     This function creates a symbol table from a CST. 
     Two functions are called to either read an entire block of code
     or to read global variable declarations while traversing through
-    the CST. Error handling is done after the CST is created.
+    the CST. Each symbol is checked for errors as it is inserted.
+    Identifiers are bound to their symbols as they are read, except
+    for calls of functions and procedures defined after them, which
+    are bound at the end.
+
+    With more than one thread (all of the cores if threadCount is 0),
+    the functions and procedures are first read into tables of their
+    own on threadCount threads, see readFunctionTables. Each one is
+    then merged in where the CST is read, in order, and only its
+    names that are declared globally are checked then, so the table
+    is the same as one read on one thread.
 */
-void SymbolTable::createSymbolTable(const ConcreteSyntaxTree& cst) {
+void SymbolTable::createSymbolTable(const ConcreteSyntaxTree& cst, unsigned int threadCount) {
     int scope = 0;
     int braceScopeCounter = 0;
+    tree = &cst;
     currentCSTNode = cst.root;
+    atoms = cst.atoms;
+    sourceMap = cst.sourceMap;
+    bindings.assign(tree->kinds.size(), Symbol::noSymbol);
+
+    // there is no tree if the source couldn't be tokenized
+    if (cst.root == ConcreteSyntaxTree::none) {
+        return;
+    }
+
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // the functions of a tree with a syntax error may not be where the
+    // scan finds them, so it is read on one thread
+    std::vector<unsigned int> functionStarts;
+    std::vector<std::unique_ptr<SymbolTable>> functionTables;
+    if (threadCount > 1 && cst.root != ConcreteSyntaxTree::none && !cst.hasSyntaxError()) {
+        functionStarts = findFunctions();
+        readFunctionTables(functionStarts, threadCount, functionTables);
+    }
+    std::size_t nextFunction = 0;
 
-    // keep running until both left child and right sibling are null
-    while (currentCSTNode->leftChild || currentCSTNode->rightSibling) {
-        if (currentCSTNode->token == "function" || currentCSTNode->token == "procedure") {
-            scope = readBlock(currentCSTNode, scope);
+    // keep running until both left child and right sibling are null,
+    // or a declaration that isn't complete is found. The last node is
+    // read too, since a declaration can't end there
+    while (!incompleteDeclaration) {
+        if (tree->kinds[currentCSTNode] == TokenKind::KEYWORD_FUNCTION ||
+            tree->kinds[currentCSTNode] == TokenKind::KEYWORD_PROCEDURE) {
+            while (nextFunction < functionTables.size() &&
+                   functionStarts[nextFunction] < currentCSTNode) {
+                nextFunction++;
+            }
+
+            // a table read on a thread is used if it was read from here,
+            // with the same scope, otherwise the function is read now
+            if (nextFunction < functionTables.size() &&
+                functionStarts[nextFunction] == currentCSTNode &&
+                static_cast<std::size_t>(scope) == nextFunction) {
+                mergeFunctionTable(*functionTables[nextFunction]);
+                functionTables[nextFunction].reset();
+                scope++;
+            }
+            else {
+                scope = readBlock(currentCSTNode, scope);
+            }
         } 
-        else if (currentCSTNode->token == "char" || currentCSTNode->token == "int" ||
-                 currentCSTNode->token == "bool") {
+        else if (Tokenization::isDatatype(tree->kinds[currentCSTNode])) {
             // read global scope variables
             createVariables(currentCSTNode, 0);
         }
         else {
-            if (currentCSTNode->rightSibling) {
-                currentCSTNode = currentCSTNode->rightSibling;
+            if (tree->rightSiblings[currentCSTNode] != ConcreteSyntaxTree::none) {
+                currentCSTNode = tree->rightSiblings[currentCSTNode];
+            }
+            else if (tree->leftChildren[currentCSTNode] != ConcreteSyntaxTree::none) {
+                currentCSTNode = tree->leftChildren[currentCSTNode];
             }
-            else if (currentCSTNode->leftChild) {
-                currentCSTNode = currentCSTNode->leftChild;
+            else {
+                break;
             }
         }
     }
 
-    // error check symbol table after creation
-    errorCheckSymbolTable();
+    bindForwardCalls();
 }
 
 /*
@@ -64,9 +133,12 @@ void SymbolTable::createSymbolTable(const ConcreteSyntaxTree& cst) {
     read in a block of code determined by the number of braces.
     The scope is incremented by 1 for each block of code. 
     Variables in the block are accounted for by calling
-    createVariables.
+    createVariables. The function's parameters and the outer block
+    of its body share a scope of the scope tree, and each block in
+    that opens a scope of its own. Identifiers used in the body are
+    bound to their symbols.
 */
-int SymbolTable::readBlock(TreeNode* currentNode, int scope) {
+int SymbolTable::readBlock(unsigned int currentNode, int scope) {
     // a new procedure means new scope
     scope++;
 
@@ -74,72 +146,103 @@ int SymbolTable::readBlock(TreeNode* currentNode, int scope) {
     int braceCounter = 0;
 
     currentCSTNode = currentNode;
-    std::string functionName;
-    Symbol* newSymbol = new Symbol();
-    insertSymbol(newSymbol);
+    Symbol newSymbol;
 
     // set symbol variables
-    currentSymbol->identifierType = currentCSTNode->token;
-    currentSymbol->scope = scope;
-    currentSymbol->lineNumber = currentCSTNode->lineNumber;
-    currentCSTNode = currentCSTNode->rightSibling;
+    TokenKind blockKind = tree->kinds[currentCSTNode];
+    newSymbol.scope = scope;
+    newSymbol.node = currentCSTNode;
+    if (!moveToSibling()) {
+        return scope;
+    }
 
-    if (currentSymbol->identifierType == "procedure") {
-        currentSymbol->datatype = "NOT APPLICABLE";
-        currentSymbol->identifierName = currentCSTNode->token;
-        functionName = currentSymbol->identifierName;
+    if (blockKind == TokenKind::KEYWORD_PROCEDURE) {
+        newSymbol.identifierType = IdentifierType::PROCEDURE;
+        newSymbol.datatype = SymbolDatatype::NOT_APPLICABLE;
+        newSymbol.identifierName = tree->valueAtoms[currentCSTNode];
     }
-    else if (currentSymbol->identifierType == "function") {
-        currentSymbol->datatype = currentCSTNode->token;
+    else if (blockKind == TokenKind::KEYWORD_FUNCTION) {
+        newSymbol.identifierType = IdentifierType::FUNCTION;
+        newSymbol.datatype = datatypeOf(tree->kinds[currentCSTNode]);
 
-        currentCSTNode = currentCSTNode->rightSibling;
-        currentSymbol->identifierName = currentCSTNode->token;
-        functionName = currentSymbol->identifierName;
+        if (!moveToSibling()) {
+            return scope;
+        }
+        newSymbol.identifierName = tree->valueAtoms[currentCSTNode];
     }
 
+    // the symbol is checked when it is inserted, so its name and scope
+    // are set first
+    unsigned int function = insertSymbol(newSymbol);
+    bind(currentCSTNode, function);
+
+    // the parameters start the function's frame
+    currentFunction = function;
+    openScope(0);
+
     // ignore void if it is there
-    currentCSTNode = currentCSTNode->rightSibling;
-    if (currentCSTNode->token == "(") {
-        currentCSTNode = currentCSTNode->rightSibling;
+    if (!moveToSibling()) {
+        return endFunction(scope);
+    }
+    if (tree->kinds[currentCSTNode] == TokenKind::LEFT_PARENTHESIS) {
+        if (!moveToSibling()) {
+            return endFunction(scope);
+        }
 
-        if (currentCSTNode->token == "void") {
-            currentCSTNode = currentCSTNode->rightSibling;
+        if (tree->kinds[currentCSTNode] == TokenKind::KEYWORD_VOID) {
+            if (!moveToSibling()) {
+                return endFunction(scope);
+            }
         }
         else {
-            if (currentCSTNode->token != ")") {
-                while (currentCSTNode->token != ")") {
-                    if (currentCSTNode->token == "int" || currentCSTNode->token == "bool" ||
-                        currentCSTNode->token == "char") {
-                        // new symbol for each parameter
-                        Symbol* newSymbol = new Symbol();
-                        insertSymbol(newSymbol);
-                        
-                        currentSymbol->isParameter = true;
-                        currentSymbol->functionName = functionName;
-                        currentSymbol->datatype = currentCSTNode->token;
-                        currentSymbol->scope = scope;
-                        currentSymbol->lineNumber = currentCSTNode->lineNumber;
-    
-                        currentCSTNode = currentCSTNode->rightSibling;
-                        currentSymbol->identifierName = currentCSTNode->token;
-    
-                        // check if array
-                        currentCSTNode = currentCSTNode->rightSibling;
-                        if (currentCSTNode->token == "[") {
-                            currentSymbol->isArray = true;
-    
-                            currentCSTNode = currentCSTNode->rightSibling;
-                            currentSymbol->arraySize = std::stoi(currentCSTNode->token);
-    
-                            currentCSTNode = currentCSTNode->rightSibling; // token = ]
-                            currentCSTNode = currentCSTNode->rightSibling; // token = )
-                        }
-    
-                        // check if more parameters
-                        if (currentCSTNode->token == ",") {
-                            // more parameters
-                            currentCSTNode = currentCSTNode->rightSibling;
-                        }
+            while (tree->kinds[currentCSTNode] != TokenKind::RIGHT_PARENTHESIS) {
+                if (!Tokenization::isDatatype(tree->kinds[currentCSTNode])) {
+                    // anything else in the parentheses is skipped
+                    if (!moveToSibling()) {
+                        return endFunction(scope);
+                    }
+                    continue;
+                }
+
+                // new symbol for each parameter
+                Symbol parameter;
+
+                parameter.isParameter = true;
+                parameter.function = function;
+                parameter.datatype = datatypeOf(tree->kinds[currentCSTNode]);
+                parameter.scope = scope;
+                parameter.node = currentCSTNode;
+
+                if (!moveToSibling()) {
+                    return endFunction(scope);
+                }
+                parameter.identifierName = tree->valueAtoms[currentCSTNode];
+                unsigned int number = insertSymbol(parameter);
+                bind(currentCSTNode, number);
+
+                // check if array
+                if (!moveToSibling()) {
+                    return endFunction(scope);
+                }
+                if (tree->kinds[currentCSTNode] == TokenKind::LEFT_BRACKET) {
+                    symbols[number].isArray = true;
+
+                    if (!moveToSibling()) {
+                        return endFunction(scope);
+                    }
+                    symbols[number].arraySize = tree->integerValues[currentCSTNode];
+
+                    // token = ], then token = , or )
+                    if (!moveToSibling() || !moveToSibling()) {
+                        return endFunction(scope);
+                    }
+                }
+
+                // check if more parameters
+                if (tree->kinds[currentCSTNode] == TokenKind::COMMA) {
+                    // more parameters
+                    if (!moveToSibling()) {
+                        return endFunction(scope);
                     }
                 }
             }
@@ -147,210 +250,738 @@ int SymbolTable::readBlock(TreeNode* currentNode, int scope) {
     }
     
     // read rest of function
-    while (currentCSTNode->rightSibling || currentCSTNode->leftChild) {
+    while (tree->rightSiblings[currentCSTNode] != ConcreteSyntaxTree::none ||
+           tree->leftChildren[currentCSTNode] != ConcreteSyntaxTree::none) {
         // get next cst token
-        if (currentCSTNode->rightSibling) {
-            currentCSTNode = currentCSTNode->rightSibling;
+        if (tree->rightSiblings[currentCSTNode] != ConcreteSyntaxTree::none) {
+            currentCSTNode = tree->rightSiblings[currentCSTNode];
         }
-        else if (currentCSTNode->leftChild) {
-            currentCSTNode = currentCSTNode->leftChild;
+        else if (tree->leftChildren[currentCSTNode] != ConcreteSyntaxTree::none) {
+            currentCSTNode = tree->leftChildren[currentCSTNode];
         }
 
         // keep track of function scope
-        if (currentCSTNode->token == "{") {
+        if (tree->kinds[currentCSTNode] == TokenKind::LEFT_BRACE) {
             braceCounter++;
+            // the outer block shares the scope of the parameters
+            if (braceCounter > 1) {
+                openScope(scopes[currentScope].nextSlot);
+            }
         }
-        else if (currentCSTNode->token == "}") {
+        else if (tree->kinds[currentCSTNode] == TokenKind::RIGHT_BRACE) {
             braceCounter--;
             if (braceCounter == 0) {
                 // reach end of functiion, exit
-                return scope;
+                break;
             }
+            closeScope();
         }
-        else if (currentCSTNode->token == "int" || currentCSTNode->token == "bool" ||
-                 currentCSTNode->token == "char") {
+        else if (Tokenization::isDatatype(tree->kinds[currentCSTNode])) {
             createVariables(currentCSTNode, scope);    
         }
+        else if (tree->kinds[currentCSTNode] == TokenKind::IDENTIFIER) {
+            bindIdentifier(currentCSTNode);
+        }
     }
-    
+
+    // back to the global scope, even if a brace was missing
+    return endFunction(scope);
+}
+
+/*
+    This function goes back to the global scope at the end of a
+    function or procedure, or where its heading stops, and returns
+    its scope.
+*/
+int SymbolTable::endFunction(int scope) {
+    currentScope = globalScope;
+    currentFunction = Symbol::noSymbol;
     return scope;
 }
 
+/*
+    This function moves currentCSTNode to its right sibling. A
+    declaration goes on in right siblings until its ;, so if there is
+    none the declaration isn't complete: the error is kept, the
+    table stops being read, and false is returned.
+*/
+bool SymbolTable::moveToSibling() {
+    unsigned int next = tree->rightSiblings[currentCSTNode];
+    if (next != ConcreteSyntaxTree::none) {
+        currentCSTNode = next;
+        return true;
+    }
+
+    // an error for a declaration before this one is kept
+    incompleteDeclaration = true;
+    if (symbols.size() < errorSymbol) {
+        errorSymbol = static_cast<unsigned int>(symbols.size());
+        invalidSyntax = true;
+        errorLineNumber = sourceMap->line(tree->locations[currentCSTNode]);
+        errorType = ": the declaration is not complete";
+    }
+    return false;
+}
+
 /*
     This function reads variables starting from the currentNode in a CST
     and adds them to the linked list. The scope of these variables are set
     to the scope that was passed in as an argument.
 */
-void SymbolTable::createVariables(TreeNode* currentNode, int scope) {
+void SymbolTable::createVariables(unsigned int currentNode, int scope) {
     currentCSTNode = currentNode;
     // save datatype incase there are multiple var declarations
-    std::string datatype = currentCSTNode->token;
+    SymbolDatatype datatype = datatypeOf(tree->kinds[currentCSTNode]);
     
-    while (currentCSTNode->token != ";") {
+    while (tree->kinds[currentCSTNode] != TokenKind::SEMICOLON) {
         // new symbol for each variable
-        Symbol* newSymbol = new Symbol();
-        insertSymbol(newSymbol);
+        Symbol variable;
         
-        currentSymbol->datatype = datatype;
-        currentSymbol->identifierType = "datatype";
-        currentSymbol->scope = scope;
-        currentSymbol->lineNumber = currentCSTNode->lineNumber;
+        variable.datatype = datatype;
+        variable.identifierType = IdentifierType::DATATYPE;
+        variable.scope = scope;
+        variable.node = currentCSTNode;
         
-        currentCSTNode = currentCSTNode->rightSibling;
-        currentSymbol->identifierName = currentCSTNode->token;
+        if (!moveToSibling()) {
+            return;
+        }
+        variable.identifierName = tree->valueAtoms[currentCSTNode];
+        unsigned int number = insertSymbol(variable);
+        bind(currentCSTNode, number);
 
-        currentCSTNode = currentCSTNode->rightSibling;
+        if (!moveToSibling()) {
+            return;
+        }
         // variable is an array
-        if (currentCSTNode->token == "[") {
-            currentSymbol->isArray = true;
+        if (tree->kinds[currentCSTNode] == TokenKind::LEFT_BRACKET) {
+            symbols[number].isArray = true;
 
-            currentCSTNode = currentCSTNode->rightSibling;
-            currentSymbol->arraySize = std::stoi(currentCSTNode->token);
+            if (!moveToSibling()) {
+                return;
+            }
+            symbols[number].arraySize = tree->integerValues[currentCSTNode];
 
             // token should now be ] after this statement
-            currentCSTNode = currentCSTNode->rightSibling;
-            currentCSTNode = currentCSTNode->rightSibling;
+            if (!moveToSibling() || !moveToSibling()) {
+                return;
+            }
         }
     }
 }
 
 /*
-    This function takes in a pointer to a symbol and adds 
-    the symbol to the private linked list of the SymbolTable class.
+    This function adds a copy of a symbol to the end of the pool of
+    the SymbolTable class and returns its index. The symbol's name and
+    scope have to be set, since it is checked against the symbols
+    before it here.
 */
-void SymbolTable::insertSymbol(Symbol* symbol) {
-    // return if symbol doesnt exist
-    if (!symbol) {
-        return;
+unsigned int SymbolTable::insertSymbol(const Symbol& symbol) {
+    unsigned int number = static_cast<unsigned int>(symbols.size());
+    symbols.push_back(symbol);
+    checkSymbol(symbol, number);
+    declareSymbol(number);
+    return number;
+}
+
+/*
+    This function checks if a symbol declares a name again that is
+    already declared in the same scope, or globally. The symbols
+    before it are found by name in two hash maps, one for every scope
+    and one for the global scope. The error that is kept is the one
+    for the earliest declaration that is declared again, at the
+    first place it is declared again, the same as comparing every
+    symbol with every symbol after it.
+*/
+void SymbolTable::checkSymbol(const Symbol &symbol, unsigned int number) {
+    unsigned long long scopedKey =
+        (static_cast<unsigned long long>(static_cast<unsigned int>(symbol.scope)) << 32) |
+        symbol.identifierName;
+    unsigned int earlier = scopedSymbols.insert(scopedKey, number);
+    if (earlier != number) {
+        reportDuplicate(symbol, earlier, true);
     }
-    // set head if there is no head
-    if (!head) {
-        head = symbol;
-        currentSymbol = head;
+
+    if (symbol.scope == 0) {
+        globalSymbols.insert(symbol.identifierName, number);
     }
     else {
-        currentSymbol->next = symbol;
-        currentSymbol = currentSymbol->next;
+        checkGlobalName(symbol);
     }
-    size++;
 }
 
 /*
-    This function traverses through the linked list of symbols
-    starting from the head and checking each one afterwards to 
-    see if there are duplicate declarations of variables. If a 
-    duplicate is found, error variables are set to true and
-    prepared for display.
+    This function checks if a symbol that isn't global has the name
+    of a global symbol before it.
 */
-void SymbolTable::errorCheckSymbolTable() {
-    // pointer to check other symbols
-    Symbol* symbolChecker = nullptr;
-    
-    // start at head
-    currentSymbol = head;
-    
-    // check linked list for same scope declaration
-    for (int i = 0; i < size; i++) {
-        // always check starting at the next symbol
-        symbolChecker = currentSymbol->next;
-        
-        // check the rest of the list same or global scope declarations
-        while (!invalidSyntax && symbolChecker) {
-            // if same name
-            if (currentSymbol->identifierName == symbolChecker->identifierName) {
-                // and same scope
-                if (currentSymbol->scope == symbolChecker->scope) {
-                    invalidSyntax = true;
-                    errorLineNumber = symbolChecker->lineNumber;
-                    errorType = ": variable \"" + symbolChecker->identifierName + 
-                                "\" is already defined locally";
+void SymbolTable::checkGlobalName(const Symbol &symbol) {
+    unsigned int global = globalSymbols.find(symbol.identifierName);
+    if (global != SymbolIndex::none) {
+        reportDuplicate(symbol, global, false);
+    }
+}
+
+/*
+    This function keeps the error for a symbol that declares the name
+    of the symbol numbered earlier again, unless there is already an
+    error for the same or an earlier declaration.
+*/
+void SymbolTable::reportDuplicate(const Symbol &symbol, unsigned int earlier, bool isLocal) {
+    if (earlier >= errorSymbol) {
+        return;
+    }
+
+    errorSymbol = earlier;
+    invalidSyntax = true;
+    errorLineNumber = sourceMap->line(tree->locations[symbol.node]);
+    errorType = ": variable \"" + atoms->name(symbol.identifierName) +
+                (isLocal ? "\" is already defined locally" : "\" is already defined globally");
+}
+
+/*
+    The default constructor starts with an empty map. The slots are
+    made by the first insert, so the table of a function that is read
+    on its own thread costs nothing for the maps it doesn't use.
+*/
+SymbolTable::SymbolIndex::SymbolIndex() : count(0) {
+}
+
+/*
+    This function returns the number of the first symbol inserted with
+    key, or adds key for number and returns number if there is none.
+    Slots are probed one after another from the key's hash.
+*/
+unsigned int SymbolTable::SymbolIndex::insert(unsigned long long key, unsigned int number) {
+    if (keys.empty()) {
+        grow();
+    }
+    std::size_t mask = keys.size() - 1;
+    for (std::size_t slot = hash(key) & mask; ; slot = (slot + 1) & mask) {
+        if (numbers[slot] == 0) {
+            keys[slot] = key;
+            numbers[slot] = number + 1;
+            count++;
+
+            // keep the map at most half full
+            if (count * 2 > keys.size()) {
+                grow();
+            }
+            return number;
+        }
+        if (keys[slot] == key) {
+            return numbers[slot] - 1;
+        }
+    }
+}
+
+/*
+    This function returns the number of the first symbol inserted with
+    key, or none if there is none.
+*/
+unsigned int SymbolTable::SymbolIndex::find(unsigned long long key) const {
+    if (keys.empty()) {
+        return none;
+    }
+    std::size_t mask = keys.size() - 1;
+    for (std::size_t slot = hash(key) & mask; numbers[slot] != 0; slot = (slot + 1) & mask) {
+        if (keys[slot] == key) {
+            return numbers[slot] - 1;
+        }
+    }
+    return none;
+}
+
+/*
+    This function returns the hash of a key, mixing its high bits,
+    which hold the scope, into the low bits that pick the slot.
+*/
+std::size_t SymbolTable::SymbolIndex::hash(unsigned long long key) {
+    key *= 0x9E3779B97F4A7C15ULL;
+    return static_cast<std::size_t>(key ^ (key >> 32));
+}
+
+/*
+    This function doubles the number of slots, or makes 16 of them,
+    and puts every key back in the map.
+*/
+void SymbolTable::SymbolIndex::grow() {
+    std::size_t slotCount = keys.empty() ? 16 : keys.size() * 2;
+    std::vector<unsigned long long> newKeys(slotCount, 0);
+    std::vector<unsigned int> newNumbers(slotCount, 0);
+    std::size_t mask = newKeys.size() - 1;
+
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        if (numbers[i] == 0) {
+            continue;
+        }
+        std::size_t slot = hash(keys[i]) & mask;
+        while (newNumbers[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        newKeys[slot] = keys[i];
+        newNumbers[slot] = numbers[i];
+    }
+
+    keys.swap(newKeys);
+    numbers.swap(newNumbers);
+}
+
+/*
+    This function places a symbol in the current scope of the scope
+    tree, and gives a variable or parameter the next slot of its
+    frame. Only the first symbol of a name in a scope can be found,
+    since any others are errors.
+*/
+void SymbolTable::declareSymbol(unsigned int number) {
+    Symbol& symbol = symbols[number];
+    symbol.scopeIndex = currentScope;
+    scopeTreeSymbols.insert(scopeKey(currentScope, symbol.identifierName), number);
+
+    if (symbol.isParameter || symbol.identifierType == IdentifierType::DATATYPE) {
+        symbol.frameSlot = scopes[currentScope].nextSlot++;
+        if (currentFunction != Symbol::noSymbol &&
+            symbols[currentFunction].frameSize < symbol.frameSlot + 1) {
+            symbols[currentFunction].frameSize = symbol.frameSlot + 1;
+        }
+    }
+}
+
+/*
+    This function opens a scope inside the current one, whose
+    variables start at firstSlot.
+*/
+void SymbolTable::openScope(unsigned int firstSlot) {
+    scopes.push_back(Scope(currentScope, firstSlot));
+    currentScope = static_cast<unsigned int>(scopes.size() - 1);
+}
+
+/*
+    This function closes the current scope, so the names declared in
+    it can't be found and its slots can be used again.
+*/
+void SymbolTable::closeScope() {
+    if (scopes[currentScope].parent != noScope) {
+        currentScope = scopes[currentScope].parent;
+    }
+}
+
+/*
+    This function binds the identifier at a CST node to the symbol of
+    its name in the nearest scope that declares it. The scopes are
+    searched from the current one out to the global scope.
+*/
+void SymbolTable::bindIdentifier(unsigned int node) {
+    unsigned int name = tree->valueAtoms[node];
+    for (unsigned int scope = currentScope; scope != noScope; scope = scopes[scope].parent) {
+        // the global names are bound when a function's table is merged
+        if (scope == globalScope && !bindsGlobals) {
+            break;
+        }
+        unsigned int number = scopeTreeSymbols.find(scopeKey(scope, name));
+        if (number != SymbolIndex::none) {
+            bind(node, number);
+            return;
+        }
+    }
+    unboundNodes.push_back(node);
+}
+
+/*
+    This function binds the identifier at a CST node to the symbol
+    numbered number. The table of a function only has bindings from
+    where the function starts, as many as it needs.
+*/
+void SymbolTable::bind(unsigned int node, unsigned int number) {
+    std::size_t index = node - bindingBase;
+    if (index >= bindings.size()) {
+        bindings.resize(index + 1, Symbol::noSymbol);
+    }
+    bindings[index] = number;
+}
+
+/*
+    This function binds the identifiers that weren't declared before
+    they were used to functions and procedures defined later.
+*/
+void SymbolTable::bindForwardCalls() {
+    for (std::size_t i = 0; i < unboundNodes.size(); i++) {
+        unsigned int node = unboundNodes[i];
+        unsigned int number = scopeTreeSymbols.find(scopeKey(globalScope, tree->valueAtoms[node]));
+        if (number != SymbolIndex::none && symbols[number].frameSlot == Symbol::noSlot) {
+            bind(node, number);
+        }
+    }
+    unboundNodes.clear();
+}
+
+/*
+    This function finds where the functions and procedures start with
+    a quick scan of the kinds of the nodes, as the function and
+    procedure keywords that aren't inside braces. A keyword is only
+    taken if it starts a whole declaration, see isFunctionStart, since
+    procedure can also be the name of a variable.
+*/
+std::vector<unsigned int> SymbolTable::findFunctions() const {
+    std::vector<unsigned int> starts;
+    int braceDepth = 0;
+    for (std::size_t node = tree->root; node < tree->kinds.size(); node++) {
+        TokenKind kind = tree->kinds[node];
+        if (kind == TokenKind::LEFT_BRACE) {
+            braceDepth++;
+        }
+        else if (kind == TokenKind::RIGHT_BRACE) {
+            braceDepth--;
+        }
+        else if (braceDepth == 0 && (kind == TokenKind::KEYWORD_FUNCTION ||
+                                     kind == TokenKind::KEYWORD_PROCEDURE) &&
+                 isFunctionStart(static_cast<unsigned int>(node))) {
+            starts.push_back(static_cast<unsigned int>(node));
+        }
+    }
+    return starts;
+}
+
+/*
+    This function returns true if the function or procedure keyword
+    at node comes after a ; or } and is followed by a heading that
+    readBlock reads up to the { of the body: the datatype of a
+    function, the name, and void or parameters in parentheses.
+*/
+bool SymbolTable::isFunctionStart(unsigned int node) const {
+    if (node != tree->root && tree->kinds[node - 1] != TokenKind::SEMICOLON &&
+        tree->kinds[node - 1] != TokenKind::RIGHT_BRACE) {
+        return false;
+    }
+
+    bool isFunction = tree->kinds[node] == TokenKind::KEYWORD_FUNCTION;
+    unsigned int next = tree->rightSiblings[node];
+    if (isFunction) {
+        if (next == ConcreteSyntaxTree::none || !Tokenization::isDatatype(tree->kinds[next])) {
+            return false;
+        }
+        next = tree->rightSiblings[next];
+    }
+    if (next == ConcreteSyntaxTree::none || tree->kinds[next] != TokenKind::IDENTIFIER) {
+        return false;
+    }
+    next = tree->rightSiblings[next];
+    if (next == ConcreteSyntaxTree::none || tree->kinds[next] != TokenKind::LEFT_PARENTHESIS) {
+        return false;
+    }
+    next = tree->rightSiblings[next];
+    if (next != ConcreteSyntaxTree::none && tree->kinds[next] == TokenKind::KEYWORD_VOID) {
+        next = tree->rightSiblings[next];
+    }
+    else {
+        // each parameter is a datatype, a name and maybe [ size ],
+        // followed by a , or the )
+        while (next != ConcreteSyntaxTree::none && tree->kinds[next] != TokenKind::RIGHT_PARENTHESIS) {
+            if (!Tokenization::isDatatype(tree->kinds[next])) {
+                return false;
+            }
+            next = tree->rightSiblings[next];
+            if (next == ConcreteSyntaxTree::none || tree->kinds[next] != TokenKind::IDENTIFIER) {
+                return false;
+            }
+            next = tree->rightSiblings[next];
+            if (next != ConcreteSyntaxTree::none && tree->kinds[next] == TokenKind::LEFT_BRACKET) {
+                next = tree->rightSiblings[next];
+                if (next == ConcreteSyntaxTree::none || tree->kinds[next] != TokenKind::INTEGER) {
+                    return false;
                 }
-                // or currentSymbol is a global variable
-                else if (currentSymbol->scope == 0) {
-                    invalidSyntax = true;
-                    errorLineNumber = symbolChecker->lineNumber;
-                    errorType = ": variable \"" + symbolChecker->identifierName + 
-                                "\" is already defined globally";
+                next = tree->rightSiblings[next];
+                if (next == ConcreteSyntaxTree::none || tree->kinds[next] != TokenKind::RIGHT_BRACKET) {
+                    return false;
                 }
+                next = tree->rightSiblings[next];
+            }
+            if (next != ConcreteSyntaxTree::none && tree->kinds[next] == TokenKind::COMMA) {
+                next = tree->rightSiblings[next];
             }
-            // check next symbol
-            symbolChecker = symbolChecker->next;
         }
-        // move to next symbol
-        currentSymbol = currentSymbol->next;
     }
-    return;
+    if (next == ConcreteSyntaxTree::none || tree->kinds[next] != TokenKind::RIGHT_PARENTHESIS) {
+        return false;
+    }
+    // the body usually starts a new line of the tree
+    next = tree->rightSiblings[next] != ConcreteSyntaxTree::none ? tree->rightSiblings[next] :
+                                                                    tree->leftChildren[next];
+    return next != ConcreteSyntaxTree::none && tree->kinds[next] == TokenKind::LEFT_BRACE;
+}
+
+/*
+    This function reads each function or procedure that starts at a
+    node in starts into a table of its own, on threadCount threads.
+    The function at starts[i] is read with the scope i, which is the
+    scope it has if every function before it is one of them too.
+*/
+void SymbolTable::readFunctionTables(const std::vector<unsigned int> &starts, unsigned int threadCount,
+                                     std::vector<std::unique_ptr<SymbolTable>> &tables) const {
+    tables.resize(starts.size());
+    std::atomic<std::size_t> nextTable(0);
+
+    // a duplicate found on a thread asks for its line, so the lines
+    // are found before the threads share the source map
+    if (sourceMap) {
+        sourceMap->buildIndex();
+    }
+
+    auto work = [&]() {
+        for (std::size_t i = nextTable++; i < starts.size(); i = nextTable++) {
+            SymbolTable* table = new SymbolTable();
+            table->tree = tree;
+            table->atoms = atoms;
+            table->sourceMap = sourceMap;
+            table->bindingBase = starts[i];
+            table->bindsGlobals = false;
+            table->readBlock(starts[i], static_cast<int>(i));
+            tables[i].reset(table);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < threadCount && i < starts.size(); i++) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (std::size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+}
+
+/*
+    This function adds the symbols, scopes and bindings of a function
+    read into a table of its own after the ones so far, as readBlock
+    would have. The names in the function were checked against each
+    other when it was read, so only the global names are checked
+    here, and the identifiers it didn't bind are bound to global names.
+*/
+void SymbolTable::mergeFunctionTable(const SymbolTable &function) {
+    unsigned int base = static_cast<unsigned int>(symbols.size());
+    // the function's scopes come after the ones so far, and the global
+    // scope is the same
+    unsigned int scopeBase = static_cast<unsigned int>(scopes.size() - 1);
+
+    for (std::size_t i = 1; i < function.scopes.size(); i++) {
+        unsigned int parent = function.scopes[i].parent;
+        scopes.push_back(Scope(parent == globalScope ? globalScope : parent + scopeBase,
+                               function.scopes[i].nextSlot));
+    }
+
+    for (std::size_t i = 0; i < function.symbols.size(); i++) {
+        Symbol symbol = function.symbols[i];
+        if (symbol.function != Symbol::noSymbol) {
+            symbol.function += base;
+        }
+        if (symbol.scopeIndex != globalScope) {
+            symbol.scopeIndex += scopeBase;
+        }
+        symbols.push_back(symbol);
+        checkGlobalName(symbol);
+    }
+    // the function's declaration that isn't complete stops the table
+    // where it would have stopped on one thread
+    if (function.incompleteDeclaration) {
+        incompleteDeclaration = true;
+    }
+    if (function.invalidSyntax && base + function.errorSymbol < errorSymbol) {
+        errorSymbol = base + function.errorSymbol;
+        invalidSyntax = true;
+        errorLineNumber = function.errorLineNumber;
+        errorType = function.errorType;
+    }
+
+    // the function itself is declared in the global scope
+    scopeTreeSymbols.insert(scopeKey(globalScope, symbols[base].identifierName), base);
+
+    for (std::size_t i = 0; i < function.bindings.size(); i++) {
+        if (function.bindings[i] != Symbol::noSymbol) {
+            bind(function.bindingBase + static_cast<unsigned int>(i), function.bindings[i] + base);
+        }
+    }
+    for (std::size_t i = 0; i < function.unboundNodes.size(); i++) {
+        unsigned int node = function.unboundNodes[i];
+        unsigned int number = scopeTreeSymbols.find(scopeKey(globalScope, tree->valueAtoms[node]));
+        if (number != SymbolIndex::none) {
+            bind(node, number);
+        }
+        else {
+            unboundNodes.push_back(node);
+        }
+    }
+
+    currentCSTNode = function.currentCSTNode;
+}
+
+/*
+    This function returns the symbol the identifier at a CST node is
+    bound to, or nullptr if it isn't bound.
+*/
+const Symbol* SymbolTable::boundSymbol(unsigned int node) const {
+    if (node < bindingBase || node - bindingBase >= bindings.size() ||
+        bindings[node - bindingBase] == Symbol::noSymbol) {
+        return nullptr;
+    }
+    return &symbols[bindings[node - bindingBase]];
+}
+
+/*
+    This function returns the symbol the identifier at an offset in the
+    source is bound to, or nullptr if there is no identifier there or
+    it isn't bound. The nodes are in the order of their offsets, so
+    the node is found by a binary search.
+*/
+const Symbol* SymbolTable::symbolAt(unsigned int location) const {
+    std::vector<unsigned int>::const_iterator node =
+        std::lower_bound(tree->locations.begin(), tree->locations.end(), location);
+    if (node == tree->locations.end() || *node != location) {
+        return nullptr;
+    }
+    return boundSymbol(static_cast<unsigned int>(node - tree->locations.begin()));
+}
+
+/*
+    This function returns the offset in the source of the first token
+    of a symbol's declaration.
+*/
+unsigned int SymbolTable::location(const Symbol &symbol) const {
+    return tree->locations[symbol.node];
+}
+
+/*
+    This function returns the parent of a scope in the scope tree, or
+    noScope for the global scope.
+*/
+unsigned int SymbolTable::parentScope(unsigned int scopeIndex) const {
+    return scopes[scopeIndex].parent;
 }
 
 /*
     This function will display the symbol table to the output file
-    if there were no errors detected, otherwise the error will be
-    displayed instead.
+    in format if there were no errors detected, otherwise the error
+    will be displayed instead.
 */
-void SymbolTable::displaySymbolTable(std::string outputFilename) {
-    // if linked list doesn't exist, return
-    if (!head) {
+void SymbolTable::displaySymbolTable(std::string outputFilename, ReportFormat format) {
+    // if there are no symbols or errors, return
+    if (symbols.empty() && !invalidSyntax) {
         return;
     }
 
-    std::ofstream outFile(outputFilename);
+    ReportWriter outFile(outputFilename, format);
 
     // if there is an error, print that out
     if (invalidSyntax) {
-        outFile << "Error on line " << errorLineNumber << errorType << std::endl;
+        if (outFile.isText()) {
+            outFile << "Error on line " << errorLineNumber << errorType << '\n';
+            return;
+        }
+        // the error starts with ": " to follow the line number
+        outFile.beginRecord("error");
+        outFile.field("line", errorLineNumber);
+        outFile.field("message", errorType.substr(errorType.compare(0, 2, ": ") == 0 ? 2 : 0));
+        outFile.endRecord();
         return;
     }
 
     // print out the delcarations in the symbol table
-    currentSymbol = head;
-    while (currentSymbol) {
-        if (!currentSymbol->isParameter) {
-            outFile << "IDENTIFIER_NAME: " << currentSymbol->identifierName << std::endl;
-            outFile << "IDENTIFIER_TYPE: " << currentSymbol->identifierType << std::endl;
-            outFile << "DATATYPE: " << currentSymbol->datatype << std::endl;
-            
-            outFile << "DATATYPE_IS_ARRAY: ";
-            if (currentSymbol->isArray) {
-                outFile << "yes" << std::endl;
-            }
-            else {
-                outFile << "no" << std::endl;
-            }
-
-            outFile << "DATATYPE_ARRAY_SIZE: " << currentSymbol->arraySize << std::endl;
-            outFile << "SCOPE: " << currentSymbol->scope << std::endl << std::endl;
+    for (std::size_t i = 0; i < symbols.size(); i++) {
+        if (!symbols[i].isParameter) {
+            displaySymbol(outFile, symbols[i]);
         }
-        currentSymbol = currentSymbol->next;
     }
 
-    // print out parameters in symbol table
-    currentSymbol = head;
-    std::string currentParamFunc;
-    while (currentSymbol) {
-        if (currentSymbol->isParameter) {
-            if (currentParamFunc != currentSymbol->functionName) {
-                currentParamFunc = currentSymbol->functionName;
-                outFile << "PARAMETER LIST FOR: " << currentSymbol->functionName << std::endl;
-            }
-
-            // output all parameters for current function
-            if (currentSymbol->functionName == currentParamFunc) {
-                outFile << "IDENTIFIER_NAME: " << currentSymbol->identifierName << std::endl;
-                outFile << "DATATYPE: " << currentSymbol->datatype << std::endl;
-    
-                outFile << "DATATYPE_IS_ARRAY: ";
-                if (currentSymbol->isArray) {
-                    outFile << "yes" << std::endl;
-                }
-                else {
-                    outFile << "no" << std::endl;
-                }
-    
-                outFile << "DATATYPE_ARRAY_SIZE: " << currentSymbol->arraySize << std::endl;
-                outFile<< "SCOPE: " << currentSymbol->scope << std::endl << std::endl;
+    // print out parameters in symbol table, under the name of their
+    // function, which is printed again when it changes
+    unsigned int currentParamFunc = AtomTable::none;
+    for (std::size_t i = 0; i < symbols.size(); i++) {
+        const Symbol &parameter = symbols[i];
+        if (!parameter.isParameter) {
+            continue;
+        }
+        unsigned int functionName = symbols[parameter.function].identifierName;
+        if (currentParamFunc != functionName) {
+            currentParamFunc = functionName;
+            if (outFile.isText()) {
+                outFile << "PARAMETER LIST FOR: " << atoms->name(functionName) << '\n';
             }
         }
-        currentSymbol = currentSymbol->next;
+        displaySymbol(outFile, parameter);
     }
     return;
 }
+
+/*
+    This function displays one declaration or parameter. A parameter
+    has no identifier type in the text, and the name of its function
+    in the records.
+*/
+void SymbolTable::displaySymbol(ReportWriter &outFile, const Symbol &symbol) const {
+    if (outFile.isText()) {
+        outFile << "IDENTIFIER_NAME: " << atoms->name(symbol.identifierName) << '\n';
+        if (!symbol.isParameter) {
+            outFile << "IDENTIFIER_TYPE: " << identifierTypeName(symbol.identifierType) << '\n';
+        }
+        outFile << "DATATYPE: " << datatypeName(symbol) << '\n';
+        outFile << "DATATYPE_IS_ARRAY: " << (symbol.isArray ? "yes" : "no") << '\n';
+        outFile << "DATATYPE_ARRAY_SIZE: " << symbol.arraySize << '\n';
+        outFile << "SCOPE: " << symbol.scope << "\n\n";
+        return;
+    }
+
+    if (symbol.isParameter) {
+        outFile.beginRecord("parameter");
+        outFile.field("function", atoms->name(symbols[symbol.function].identifierName));
+    }
+    else {
+        outFile.beginRecord("symbol");
+    }
+    outFile.field("name", atoms->name(symbol.identifierName));
+    if (!symbol.isParameter) {
+        outFile.field("identifierType", std::string(identifierTypeName(symbol.identifierType)));
+    }
+    outFile.field("datatype", datatypeName(symbol));
+    outFile.field("isArray", symbol.isArray);
+    outFile.field("arraySize", symbol.arraySize);
+    outFile.field("scope", symbol.scope);
+    outFile.field("line", sourceMap->line(tree->locations[symbol.node]));
+    outFile.endRecord();
+}
+
+/*
+    This function returns the name an identifier type is displayed as.
+*/
+const char* SymbolTable::identifierTypeName(IdentifierType type) const {
+    switch (type) {
+        case IdentifierType::FUNCTION: return "function";
+        case IdentifierType::PROCEDURE: return "procedure";
+        default: return "datatype";
+    }
+}
+
+/*
+    This function returns the name a symbol's datatype is displayed
+    as. The datatype of a function that isn't int, char or bool is
+    the text of the token after the function keyword.
+*/
+std::string SymbolTable::datatypeName(const Symbol &symbol) const {
+    switch (symbol.datatype) {
+        case SymbolDatatype::INT: return "int";
+        case SymbolDatatype::CHAR: return "char";
+        case SymbolDatatype::BOOL: return "bool";
+        case SymbolDatatype::OTHER:
+            return atoms->name(tree->valueAtoms[tree->rightSiblings[symbol.node]]);
+        default: return "NOT APPLICABLE";
+    }
+}
+
+/*
+    This function returns the datatype of the token kind that a
+    declaration starts with.
+*/
+SymbolDatatype SymbolTable::datatypeOf(TokenKind kind) {
+    switch (kind) {
+        case TokenKind::KEYWORD_INT: return SymbolDatatype::INT;
+        case TokenKind::KEYWORD_CHAR: return SymbolDatatype::CHAR;
+        case TokenKind::KEYWORD_BOOL: return SymbolDatatype::BOOL;
+        default: return SymbolDatatype::OTHER;
+    }
+}
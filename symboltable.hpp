@@ -3,41 +3,99 @@
     by: Kathy
 
     SymbolTable header file
-    Description: The SymbolTable class contains a struct 
-    Symbol that is used to create a linked list of 
-    functions, procedures, and variable declarations.
+    Description: The SymbolTable class keeps a Symbol for each
+    function, procedure, and variable declaration. The symbols are
+    kept one after another in a pool, which is freed all at once.
+    The symbols are also kept in hash maps by scope and name,
+    so a name declared again is found as it is inserted.
+
+    Besides the scope numbers that are displayed, the symbols are
+    placed in a tree of scopes: the global scope, a scope for each
+    function and procedure, and a scope for each block nested in its
+    body. Every identifier used in a body, and the name in every
+    declaration, is bound to the symbol it names when the table is
+    created, and every variable and parameter
+    is given a slot in the frame of its function, or in the global
+    frame, so nothing is searched for by name after that.
+
+    The functions and procedures can also be read on threads, each into
+    a table of its own, which are merged in order into the same table
+    one thread would create.
 */    
 
 #ifndef SYMBOL_TABLE_HPP
 #define SYMBOL_TABLE_HPP
 
+#include <cstddef>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "concretesyntaxtree.hpp"
 
+/*
+    What a symbol is declared as.
+*/
+enum class IdentifierType : unsigned char {
+    DATATYPE,
+    FUNCTION,
+    PROCEDURE
+};
+
+/*
+    The datatype of a symbol. A procedure has none, and OTHER is a
+    function whose datatype is some other token, which the CST doesn't
+    check.
+*/
+enum class SymbolDatatype : unsigned char {
+    NOT_APPLICABLE,
+    INT,
+    CHAR,
+    BOOL,
+    OTHER
+};
+
+/*
+    A symbol is kept in the symbol table's pool, and is found by its
+    index in it. Names are atoms in the tokenizer's AtomTable.
+*/
 struct Symbol {
-    bool isParameter;
-    std::string functionName;
-    std::string identifierName;
-    std::string identifierType;
-    std::string datatype;
-    bool isArray;
+    unsigned int identifierName;
+    // index of the function or procedure of a parameter, or noSymbol
+    unsigned int function;
+    // CST node of the first token of the declaration
+    unsigned int node;
     int arraySize;
     int scope;
-    int lineNumber;
-    Symbol* next;
+    // index of the scope in the scope tree that the name is declared in
+    unsigned int scopeIndex;
+    // slot of a variable or parameter in its frame, or noSlot
+    unsigned int frameSlot;
+    // number of slots in the frame of a function or procedure
+    unsigned int frameSize;
+    IdentifierType identifierType;
+    SymbolDatatype datatype;
+    bool isParameter;
+    bool isArray;
+
+    // index of a symbol that isn't there, and slot of a symbol that
+    // isn't a variable or parameter
+    static const unsigned int noSymbol = 0xFFFFFFFFu;
+    static const unsigned int noSlot = 0xFFFFFFFFu;
 
     // default constructor
-    Symbol() : isParameter(false),
-               functionName(""),
-               identifierName(""),
-               identifierType(""),
-               datatype(""),
-               isArray(false),
+    Symbol() : identifierName(AtomTable::none),
+               function(noSymbol),
+               node(0),
                arraySize(0),
                scope(0),
-               lineNumber(0),
-               next(nullptr) {}
+               scopeIndex(0),
+               frameSlot(noSlot),
+               frameSize(0),
+               identifierType(IdentifierType::DATATYPE),
+               datatype(SymbolDatatype::NOT_APPLICABLE),
+               isParameter(false),
+               isArray(false) {}
 };
 
 class SymbolTable {
@@ -46,20 +104,132 @@ class SymbolTable {
         SymbolTable();
 
         // member functions
-        void createSymbolTable(const ConcreteSyntaxTree& cst);
-        int readBlock(TreeNode* currentNode, int scope);
-        void createVariables(TreeNode* currentNode, int scope);
-        void insertSymbol(Symbol* symbol);
-        void displaySymbolTable(std::string outputFilename);
+        void createSymbolTable(const ConcreteSyntaxTree& cst, unsigned int threadCount = 1);
+        int readBlock(unsigned int currentNode, int scope);
+        void createVariables(unsigned int currentNode, int scope);
+        unsigned int insertSymbol(const Symbol& symbol);
+        void displaySymbolTable(std::string outputFilename,
+                                ReportFormat format = ReportFormat::TEXT);
+        const Symbol* boundSymbol(unsigned int node) const;
+        const Symbol* symbolAt(unsigned int location) const;
+        unsigned int location(const Symbol &symbol) const;
+        bool hasSyntaxError() const { return invalidSyntax; }
+        unsigned int parentScope(unsigned int scopeIndex) const;
+        unsigned int globalFrameSize() const { return scopes[0].nextSlot; }
+
+        // index of the global scope, and parent of it
+        static const unsigned int globalScope = 0;
+        static const unsigned int noScope = 0xFFFFFFFFu;
+
+        // friend class
+        friend class Interpreter;
 
     private:
-        Symbol* head;
-        Symbol* currentSymbol;
-        TreeNode* currentCSTNode;
-        int size;
+        /*
+            An open addressing hash map from a key to the number of
+            the first symbol inserted with it, in insertion order.
+            Slots are probed one after another, like AtomTable's.
+        */
+        class SymbolIndex {
+            public:
+                // default constructor
+                SymbolIndex();
+
+                // member functions
+                unsigned int insert(unsigned long long key, unsigned int number);
+                unsigned int find(unsigned long long key) const;
+
+                // number of a symbol that isn't there
+                static const unsigned int none = 0xFFFFFFFFu;
+
+            private:
+                static std::size_t hash(unsigned long long key);
+                void grow();
+
+                std::vector<unsigned long long> keys;
+                // symbol number + 1 in each used slot, 0 in empty slots
+                std::vector<unsigned int> numbers;
+                std::size_t count;
+        };
+
+        /*
+            A scope of the scope tree. The variables declared in a
+            scope take the slots after the ones its parents have
+            taken, so the slots of a block are used again by the
+            blocks after it.
+        */
+        struct Scope {
+            unsigned int parent;
+            // slot of the next variable declared in the scope
+            unsigned int nextSlot;
+
+            Scope(unsigned int parentScope, unsigned int firstSlot) :
+                parent(parentScope), nextSlot(firstSlot) {}
+        };
+
+        // the symbols, in the order they were inserted
+        std::vector<Symbol> symbols;
+        // the CST the symbols are read from
+        const ConcreteSyntaxTree* tree;
+        unsigned int currentCSTNode;
+        // names of the symbols, owned by the tokenizer
+        const AtomTable* atoms;
+        // lines of the source, owned by the tokenizer
+        const SourceMap* sourceMap;
+
+        void displaySymbol(ReportWriter &outFile, const Symbol &symbol) const;
+        const char* identifierTypeName(IdentifierType type) const;
+        std::string datatypeName(const Symbol &symbol) const;
+        static SymbolDatatype datatypeOf(TokenKind kind);
+
+        // the scope tree and the binding of identifiers
+        void declareSymbol(unsigned int number);
+        void openScope(unsigned int firstSlot);
+        void closeScope();
+        void bindIdentifier(unsigned int node);
+        void bind(unsigned int node, unsigned int number);
+        void bindForwardCalls();
+        int endFunction(int scope);
+        bool moveToSibling();
+        static unsigned long long scopeKey(unsigned int scope, unsigned int name) {
+            return (static_cast<unsigned long long>(scope) << 32) | name;
+        }
+        std::vector<Scope> scopes;
+        unsigned int currentScope;
+        // function or procedure whose body is being read, or noSymbol
+        unsigned int currentFunction;
+        // first symbol of each name in each scope of the scope tree
+        SymbolIndex scopeTreeSymbols;
+        // symbol each CST node names, by node number from bindingBase,
+        // or noSymbol
+        std::vector<unsigned int> bindings;
+        unsigned int bindingBase;
+        // false in the table of one function, whose identifiers that
+        // name global symbols are bound when the table is merged
+        bool bindsGlobals;
+        // CST nodes of identifiers not declared before they are used
+        std::vector<unsigned int> unboundNodes;
+
+        // first symbol of each scope and name, and of each global name
+        SymbolIndex scopedSymbols;
+        SymbolIndex globalSymbols;
+
+        // reading the functions on threads
+        std::vector<unsigned int> findFunctions() const;
+        bool isFunctionStart(unsigned int node) const;
+        void readFunctionTables(const std::vector<unsigned int> &starts, unsigned int threadCount,
+                                std::vector<std::unique_ptr<SymbolTable>> &tables) const;
+        void mergeFunctionTable(const SymbolTable &function);
 
         // error handling
-        void errorCheckSymbolTable();
+        void checkSymbol(const Symbol &symbol, unsigned int number);
+        void checkGlobalName(const Symbol &symbol);
+        void reportDuplicate(const Symbol &symbol, unsigned int earlier, bool isLocal);
+        // number of the earlier symbol that the error is for
+        unsigned int errorSymbol;
+        // true once a declaration that the tree ends in the middle of
+        // is found, which stops the table being read
+        bool incompleteDeclaration;
         bool invalidSyntax;
         int errorLineNumber;
         std::string errorType;
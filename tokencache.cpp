@@ -0,0 +1,399 @@
+/*
+    Implementation of the TokenCache class
+    by: Kathy
+
+    Description: This file contains the implementation of the
+    TokenCache class functions declared in the header file. An entry
+    is a header followed by the sections of the token list, each one
+    starting at a multiple of 8 bytes:
+
+        tokens, atom text, atom offsets, atom hashes, atom slots,
+        extra values, extra locations, skipped newlines, checkpoints,
+        comment error lines, invalid token type
+
+    The header holds the size of each section and a hash of the header
+    itself. Entries are only ever renamed into place whole, so loading
+    one checks the header and that the sections fill the file, and
+    then that every number in the tokens is in range, instead of
+    hashing the sections again on every hit.
+*/
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+
+#include "tokencache.hpp"
+#include "binarysections.hpp"
+#include "sourcebuffer.hpp"
+
+const char* const TokenCache::toolVersion = "assign4 tokens 14";
+
+namespace {
+
+const std::uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+const std::uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+const std::uint64_t prime3 = 0x165667B19E3779F9ULL;
+const std::uint64_t prime4 = 0x85EBCA77C2B2AE63ULL;
+const std::uint64_t prime5 = 0x27D4EB2F165667C5ULL;
+
+const char entryMagic[8] = {'T', 'O', 'K', 'C', 'A', 'C', 'H', 'E'};
+const std::uint32_t formatVersion = 2;
+
+/*
+    The sections of an entry, in the order they are written.
+*/
+enum Section {
+    TOKENS,
+    ATOM_TEXT,
+    ATOM_OFFSETS,
+    ATOM_HASHES,
+    ATOM_SLOTS,
+    EXTRA_VALUES,
+    EXTRA_LOCATIONS,
+    SKIPPED_NEWLINES,
+    CHECKPOINTS,
+    COMMENT_ERRORS,
+    INVALID_TYPE,
+    SECTION_COUNT
+};
+
+/*
+    The header at the start of an entry.
+*/
+struct EntryHeader {
+    char magic[8];
+    std::uint32_t formatVersion;
+    std::uint32_t tokenSize;
+    char toolVersion[32];
+    std::uint64_t sourceHash;
+    std::uint64_t sourceLength;
+    std::uint64_t headerHash;
+    std::uint64_t sectionSizes[SECTION_COUNT];
+    std::uint64_t errorOffset;
+    std::int32_t errorLineNumber;
+    std::uint8_t skipComments;
+    std::uint8_t invalidToken;
+    std::uint8_t unused[2];
+};
+
+static_assert(std::is_trivially_copyable<Token>::value, "tokens are written as they are");
+static_assert(sizeof(EntryHeader) % 8 == 0, "sections start at a multiple of 8 bytes");
+
+inline std::uint64_t rotateLeft(std::uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline std::uint64_t read64(const char* data) {
+    std::uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline std::uint32_t read32(const char* data) {
+    std::uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline std::uint64_t hashRound(std::uint64_t accumulator, std::uint64_t input) {
+    accumulator += input * prime2;
+    accumulator = rotateLeft(accumulator, 31);
+    return accumulator * prime1;
+}
+
+inline std::uint64_t mergeRound(std::uint64_t accumulator, std::uint64_t value) {
+    accumulator ^= hashRound(0, value);
+    return accumulator * prime1 + prime4;
+}
+
+}
+
+/*
+    The constructor keeps entries in directory, which is made when the
+    first entry is stored if it doesn't exist.
+*/
+TokenCache::TokenCache(const std::string &directory) : directory(directory) {
+}
+
+/*
+    This function fills the tokenizer's token list for the source from
+    begin to end, from the cache if it has an entry for the source,
+    otherwise by tokenizing it on threadCount threads and storing the
+    result. Returns true if the entry was used.
+*/
+bool TokenCache::tokenize(Tokenization &tokenizer, const char* begin, const char* end,
+                          bool skipComments, unsigned int threadCount) {
+    if (load(tokenizer, begin, end, skipComments)) {
+        return true;
+    }
+
+    tokenizer.tokenizeParallel(begin, end, skipComments, threadCount);
+    store(tokenizer, begin, end);
+    return false;
+}
+
+/*
+    This function fills the tokenizer with the entry for the source
+    from begin to end, and reports the unterminated comments that were
+    reported when it was tokenized. Returns false, and leaves the
+    tokenizer as it was, if there is no entry or it is stale or
+    corrupt.
+*/
+bool TokenCache::load(Tokenization &tokenizer, const char* begin, const char* end,
+                      bool skipComments) {
+    std::size_t sourceLength = end - begin;
+    unsigned long long sourceHash;
+    SourceBuffer entry;
+    if (begin == end || !entry.open(entryName(begin, end, skipComments, sourceHash))) {
+        return false;
+    }
+
+    // check that the entry is for this source and tool version
+    EntryHeader header;
+    if (entry.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, entry.begin(), sizeof(header));
+    std::uint64_t headerHash = header.headerHash;
+    header.headerHash = 0;
+    if (hash(reinterpret_cast<const char*>(&header), sizeof(header)) != headerHash ||
+        std::memcmp(header.magic, entryMagic, sizeof(entryMagic)) != 0 ||
+        header.formatVersion != formatVersion || header.tokenSize != sizeof(Token) ||
+        std::strncmp(header.toolVersion, toolVersion, sizeof(header.toolVersion)) != 0 ||
+        header.sourceHash != sourceHash || header.sourceLength != sourceLength ||
+        header.skipComments != (skipComments ? 1 : 0)) {
+        return false;
+    }
+
+    // check that the entry is whole
+    const char* sections[SECTION_COUNT];
+    if (!BinarySections::locate(entry.begin(), entry.size(), sizeof(header),
+                                header.sectionSizes, SECTION_COUNT, sections)) {
+        return false;
+    }
+
+    Tokenization loaded;
+    AtomTable &atoms = loaded.atoms;
+    std::vector<unsigned int> skippedNewlines;
+    if (!BinarySections::read(sections[TOKENS], header.sectionSizes[TOKENS], loaded.tokenList) ||
+        !BinarySections::read(sections[ATOM_TEXT], header.sectionSizes[ATOM_TEXT], atoms.text) ||
+        !BinarySections::read(sections[ATOM_OFFSETS], header.sectionSizes[ATOM_OFFSETS], atoms.offsets) ||
+        !BinarySections::read(sections[ATOM_HASHES], header.sectionSizes[ATOM_HASHES], atoms.hashes) ||
+        !BinarySections::read(sections[ATOM_SLOTS], header.sectionSizes[ATOM_SLOTS], atoms.slots) ||
+        !BinarySections::read(sections[EXTRA_VALUES], header.sectionSizes[EXTRA_VALUES], loaded.extraValues) ||
+        !BinarySections::read(sections[EXTRA_LOCATIONS], header.sectionSizes[EXTRA_LOCATIONS],
+                     loaded.extraLocations) ||
+        !BinarySections::read(sections[SKIPPED_NEWLINES], header.sectionSizes[SKIPPED_NEWLINES],
+                     skippedNewlines) ||
+        !BinarySections::read(sections[CHECKPOINTS], header.sectionSizes[CHECKPOINTS], loaded.checkpoints) ||
+        !BinarySections::read(sections[COMMENT_ERRORS], header.sectionSizes[COMMENT_ERRORS],
+                     loaded.commentErrors) ||
+        !BinarySections::read(sections[INVALID_TYPE], header.sectionSizes[INVALID_TYPE], loaded.invalidType)) {
+        return false;
+    }
+    if (atoms.offsets.size() != atoms.hashes.size() + 1 || atoms.offsets.back() != atoms.text.size() ||
+        atoms.slots.size() < 2 * atoms.hashes.size() ||
+        (atoms.slots.size() & (atoms.slots.size() - 1)) != 0) {
+        return false;
+    }
+
+    // check that every number in the tokens, atoms and checkpoints is a
+    // kind, atom, token or place in the source that exists
+    std::uint64_t valuesLength = sourceLength + loaded.extraValues.size();
+    for (std::size_t i = 0; i < loaded.tokenList.size(); i++) {
+        const Token &token = loaded.tokenList[i];
+        if (token.kind > TokenKind::KEYWORD_PRINTF ||
+            static_cast<std::uint64_t>(token.offset) + token.length > valuesLength ||
+            (token.atom != AtomTable::none && token.atom >= atoms.size())) {
+            return false;
+        }
+    }
+    for (std::size_t i = 1; i < atoms.offsets.size(); i++) {
+        if (atoms.offsets[i] < atoms.offsets[i - 1]) {
+            return false;
+        }
+    }
+    for (std::size_t i = 0; i < atoms.slots.size(); i++) {
+        if (atoms.slots[i] > atoms.size()) {
+            return false;
+        }
+    }
+    for (std::size_t i = 0; i < loaded.checkpoints.size(); i++) {
+        if (loaded.checkpoints[i].position > sourceLength ||
+            loaded.checkpoints[i].tokenIndex > loaded.tokenList.size()) {
+            return false;
+        }
+    }
+
+    // the entry is good, replace the tokenizer's tokens with it
+    tokenizer.clearTokens();
+    tokenizer.setSource(begin, end);
+    tokenizer.skippingComments = skipComments;
+    tokenizer.tokenList.swap(loaded.tokenList);
+    std::swap(tokenizer.atoms, loaded.atoms);
+    tokenizer.extraValues.swap(loaded.extraValues);
+    tokenizer.extraLocations.swap(loaded.extraLocations);
+    for (std::size_t i = 0; i < skippedNewlines.size(); i++) {
+        tokenizer.sourceMap.skipNewline(skippedNewlines[i]);
+    }
+    tokenizer.checkpoints.swap(loaded.checkpoints);
+    tokenizer.commentErrors.swap(loaded.commentErrors);
+    tokenizer.invalidToken = header.invalidToken != 0;
+    tokenizer.invalidType.swap(loaded.invalidType);
+    tokenizer.errorLineNumber = header.errorLineNumber;
+    tokenizer.errorOffset = header.errorOffset;
+
+    for (std::size_t i = 0; i < tokenizer.commentErrors.size(); i++) {
+        RemoveComments::unterminatedComment(tokenizer.commentErrors[i]);
+    }
+    return true;
+}
+
+/*
+    This function writes an entry for the tokenizer's token list of the
+    source from begin to end. The entry is written to a temporary file
+    first and then renamed, so a partly written entry is never read.
+    Returns false if the entry couldn't be written.
+*/
+bool TokenCache::store(const Tokenization &tokenizer, const char* begin, const char* end) {
+    // an empty source is reported each time it is tokenized
+    if (begin == end || tokenizer.checkpoints.empty()) {
+        return false;
+    }
+
+    EntryHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, entryMagic, sizeof(entryMagic));
+    header.formatVersion = formatVersion;
+    header.tokenSize = sizeof(Token);
+    std::strncpy(header.toolVersion, toolVersion, sizeof(header.toolVersion) - 1);
+    unsigned long long sourceHash;
+    std::string name = entryName(begin, end, tokenizer.skippingComments, sourceHash);
+    header.sourceHash = sourceHash;
+    header.sourceLength = end - begin;
+    header.errorOffset = tokenizer.errorOffset;
+    header.errorLineNumber = tokenizer.errorLineNumber;
+    header.skipComments = tokenizer.skippingComments ? 1 : 0;
+    header.invalidToken = tokenizer.invalidToken ? 1 : 0;
+
+    std::vector<unsigned int> skippedNewlines(tokenizer.sourceMap.skippedCount());
+    for (std::size_t i = 0; i < skippedNewlines.size(); i++) {
+        skippedNewlines[i] = tokenizer.sourceMap.skippedAt(i);
+    }
+
+    // the sections, after room for the header
+    const AtomTable &atoms = tokenizer.atoms;
+    std::string entry(sizeof(header), '\0');
+    BinarySections::append(entry, header.sectionSizes[TOKENS], tokenizer.tokenList.data(), tokenizer.tokenList.size());
+    BinarySections::append(entry, header.sectionSizes[ATOM_TEXT], atoms.text.data(), atoms.text.size());
+    BinarySections::append(entry, header.sectionSizes[ATOM_OFFSETS], atoms.offsets.data(), atoms.offsets.size());
+    BinarySections::append(entry, header.sectionSizes[ATOM_HASHES], atoms.hashes.data(), atoms.hashes.size());
+    BinarySections::append(entry, header.sectionSizes[ATOM_SLOTS], atoms.slots.data(), atoms.slots.size());
+    BinarySections::append(entry, header.sectionSizes[EXTRA_VALUES], tokenizer.extraValues.data(),
+                  tokenizer.extraValues.size());
+    BinarySections::append(entry, header.sectionSizes[EXTRA_LOCATIONS], tokenizer.extraLocations.data(),
+                  tokenizer.extraLocations.size());
+    BinarySections::append(entry, header.sectionSizes[SKIPPED_NEWLINES], skippedNewlines.data(), skippedNewlines.size());
+    BinarySections::append(entry, header.sectionSizes[CHECKPOINTS], tokenizer.checkpoints.data(),
+                  tokenizer.checkpoints.size());
+    BinarySections::append(entry, header.sectionSizes[COMMENT_ERRORS], tokenizer.commentErrors.data(),
+                  tokenizer.commentErrors.size());
+    BinarySections::append(entry, header.sectionSizes[INVALID_TYPE], tokenizer.invalidType.data(),
+                  tokenizer.invalidType.size());
+    header.headerHash = hash(reinterpret_cast<const char*>(&header), sizeof(header));
+    std::memcpy(&entry[0], &header, sizeof(header));
+
+    if (::mkdir(directory.c_str(), 0777) != 0 && errno != EEXIST) {
+        return false;
+    }
+    std::string temporaryName = name + "." + std::to_string(::getpid()) + ".tmp";
+    {
+        std::ofstream outFile(temporaryName, std::ios::binary | std::ios::trunc);
+        outFile.write(entry.data(), entry.size());
+        if (!outFile) {
+            outFile.close();
+            std::remove(temporaryName.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporaryName.c_str(), name.c_str()) != 0) {
+        std::remove(temporaryName.c_str());
+        return false;
+    }
+    return true;
+}
+
+/*
+    This function returns the path of the entry for a source, and the
+    hash of the source in sourceHash. The tool version and whether
+    comments are skipped are part of the name.
+*/
+std::string TokenCache::entryName(const char* begin, const char* end, bool skipComments,
+                                  unsigned long long &sourceHash) const {
+    unsigned long long seed = hash(toolVersion, std::strlen(toolVersion), skipComments ? 1 : 0);
+    sourceHash = hash(begin, end - begin, seed);
+
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", sourceHash);
+    return directory + "/" + name + ".tokens";
+}
+
+/*
+    This function returns the 64-bit xxHash (XXH64) of length bytes
+    at data, reading 32 bytes at a time.
+*/
+unsigned long long TokenCache::hash(const char* data, std::size_t length,
+                                    unsigned long long seed) {
+    const char* end = data + length;
+    std::uint64_t result;
+
+    if (length >= 32) {
+        std::uint64_t lane1 = seed + prime1 + prime2;
+        std::uint64_t lane2 = seed + prime2;
+        std::uint64_t lane3 = seed;
+        std::uint64_t lane4 = seed - prime1;
+        for (; end - data >= 32; data += 32) {
+            lane1 = hashRound(lane1, read64(data));
+            lane2 = hashRound(lane2, read64(data + 8));
+            lane3 = hashRound(lane3, read64(data + 16));
+            lane4 = hashRound(lane4, read64(data + 24));
+        }
+        result = rotateLeft(lane1, 1) + rotateLeft(lane2, 7) +
+                 rotateLeft(lane3, 12) + rotateLeft(lane4, 18);
+        result = mergeRound(result, lane1);
+        result = mergeRound(result, lane2);
+        result = mergeRound(result, lane3);
+        result = mergeRound(result, lane4);
+    }
+    else {
+        result = seed + prime5;
+    }
+    result += length;
+
+    // the last bytes, 8, 4 and then 1 at a time
+    for (; end - data >= 8; data += 8) {
+        result ^= hashRound(0, read64(data));
+        result = rotateLeft(result, 27) * prime1 + prime4;
+    }
+    if (end - data >= 4) {
+        result ^= static_cast<std::uint64_t>(read32(data)) * prime1;
+        result = rotateLeft(result, 23) * prime2 + prime3;
+        data += 4;
+    }
+    for (; data != end; data++) {
+        result ^= static_cast<std::uint64_t>(static_cast<unsigned char>(*data)) * prime5;
+        result = rotateLeft(result, 11) * prime1;
+    }
+
+    result ^= result >> 33;
+    result *= prime2;
+    result ^= result >> 29;
+    result *= prime3;
+    result ^= result >> 32;
+    return result;
+}
@@ -0,0 +1,47 @@
+/*
+    TokenCache header file
+    by: Kathy
+
+    Description: The TokenCache class keeps the token lists of sources
+    in a cache directory, so a source that hasn't changed since it was
+    last tokenized doesn't have to be tokenized again. An entry is
+    named by a hash of the source and the tool version, and holds the
+    token list in a binary format that is read back with one mmap.
+    An entry that is stale or corrupt is found by its header, its
+    length and the numbers in its tokens, and is made again.
+*/
+
+#ifndef TOKEN_CACHE_HPP
+#define TOKEN_CACHE_HPP
+
+#include <cstddef>
+#include <string>
+
+#include "tokenization.hpp"
+
+class TokenCache {
+    public:
+        // constructor
+        explicit TokenCache(const std::string &directory);
+
+        // member functions
+        bool tokenize(Tokenization &tokenizer, const char* begin, const char* end,
+                      bool skipComments, unsigned int threadCount = 1);
+        bool load(Tokenization &tokenizer, const char* begin, const char* end,
+                  bool skipComments);
+        bool store(const Tokenization &tokenizer, const char* begin, const char* end);
+        static unsigned long long hash(const char* data, std::size_t length,
+                                       unsigned long long seed = 0);
+
+        // version of the tokens in the cache, it has to change whenever
+        // the tokenizer finds different tokens or the format changes
+        static const char* const toolVersion;
+
+    private:
+        std::string entryName(const char* begin, const char* end, bool skipComments,
+                              unsigned long long &sourceHash) const;
+
+        std::string directory;
+};
+
+#endif
@@ -7,514 +7,1611 @@
     file.
 */
 
-#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <thread>
 
 #include "tokenization.hpp"
+#include "removecomments.hpp"
+#include "charscan.hpp"
 
 /*
-    This enumerated class contains the Backus-Naur form
-    tokens.
+    This enumerated class contains the classes of characters that the
+    tokenizer tells apart. END_OF_FILE is the class of EOF.
 */
-enum class BNF {
-    START,
-    ESCAPED_CHARACTER,
+enum class CharClass : unsigned char {
+    END_OF_FILE,
+    OTHER,
+    NEWLINE,
+    SPACE,
+    OTHER_SPACE,
+    LETTER,
+    DIGIT,
+    UNDERSCORE,
+    BACKSLASH,
+    DOUBLE_QUOTE,
+    SINGLE_QUOTE,
     L_PAREN,
     R_PAREN,
     L_BRACKET,
     R_BRACKET,
     L_BRACE,
     R_BRACE,
-    DOUBLE_QUOTE,
-    SINGLE_QUOTE,
     SEMICOLON,
     COMMA,
-    ASSIGNMENT_OPERATOR,
+    EQUALS,
     PLUS,
     MINUS,
     ASTERISK,
-    DIVIDE,
-    MODULO,
+    SLASH,
+    PERCENT,
     CARET,
-    LT,
-    GT,
-    LT_EQUAL,
-    GT_EQUAL,
-    BOOLEAN_AND,
-    BOOLEAN_OR,
-    BOOLEAN_NOT,
-    BOOLEAN_EQUAL,
-    BOOLEAN_NOT_EQUAL,
-    STRING,
+    LESS,
+    GREATER,
+    AMPERSAND,
+    BAR,
+    EXCLAMATION,
+    COUNT
+};
+
+/*
+    This enumerated class contains what the tokenizer does with the
+    first character of a token.
+*/
+enum class Action : unsigned char {
+    SKIP,        // spaces and newlines
+    REPEAT,      // other whitespace repeats the last token
+    DROP,        // characters that can't start a token
+    SINGLE,      // one character token
+    PAIR,        // one or two character token, such as < or <=
+    PAIR_ONLY,   // two character token or nothing, such as &&
+    SIGN,        // + or -, or the sign of an integer
+    QUOTE,       // opening quote of a string
+    ESCAPE,
     INTEGER,
     IDENTIFIER
 };
 
 /*
-    The default constructor initializes the variables declared
-    in the header file.
+    A transition tells what to do with a character of a class in the
+    start state. kind is the kind of the token it starts, pairKind is
+    the kind when it is followed by second.
+*/
+struct Transition {
+    Action action;
+    TokenKind kind;
+    char second;
+    TokenKind pairKind;
+};
+
+/*
+    This function returns the class of a character, or of EOF. It is
+    only used to build charClasses when compiling.
+*/
+constexpr CharClass classify(int c) {
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+        return CharClass::LETTER;
+    }
+    if (c >= '0' && c <= '9') {
+        return CharClass::DIGIT;
+    }
+
+    switch (c) {
+        case EOF:  return CharClass::END_OF_FILE;
+        case '\n': return CharClass::NEWLINE;
+        case ' ':  return CharClass::SPACE;
+        case '\t': case '\v': case '\f': case '\r':
+                   return CharClass::OTHER_SPACE;
+        case '_':  return CharClass::UNDERSCORE;
+        case '\\': return CharClass::BACKSLASH;
+        case '"':  return CharClass::DOUBLE_QUOTE;
+        case '\'': return CharClass::SINGLE_QUOTE;
+        case '(':  return CharClass::L_PAREN;
+        case ')':  return CharClass::R_PAREN;
+        case '[':  return CharClass::L_BRACKET;
+        case ']':  return CharClass::R_BRACKET;
+        case '{':  return CharClass::L_BRACE;
+        case '}':  return CharClass::R_BRACE;
+        case ';':  return CharClass::SEMICOLON;
+        case ',':  return CharClass::COMMA;
+        case '=':  return CharClass::EQUALS;
+        case '+':  return CharClass::PLUS;
+        case '-':  return CharClass::MINUS;
+        case '*':  return CharClass::ASTERISK;
+        case '/':  return CharClass::SLASH;
+        case '%':  return CharClass::PERCENT;
+        case '^':  return CharClass::CARET;
+        case '<':  return CharClass::LESS;
+        case '>':  return CharClass::GREATER;
+        case '&':  return CharClass::AMPERSAND;
+        case '|':  return CharClass::BAR;
+        case '!':  return CharClass::EXCLAMATION;
+        default:   return CharClass::OTHER;
+    }
+}
+
+/*
+    This function returns the transition for a class of characters.
+    It is only used to build transitions when compiling.
+*/
+constexpr Transition transitionFor(CharClass charClass) {
+    switch (charClass) {
+        case CharClass::NEWLINE:
+        case CharClass::SPACE:
+            return {Action::SKIP, TokenKind::IDENTIFIER, 0, TokenKind::IDENTIFIER};
+        case CharClass::OTHER_SPACE:
+            return {Action::REPEAT, TokenKind::IDENTIFIER, 0, TokenKind::IDENTIFIER};
+        case CharClass::LETTER:
+            return {Action::IDENTIFIER, TokenKind::IDENTIFIER, 0, TokenKind::IDENTIFIER};
+        case CharClass::DIGIT:
+            return {Action::INTEGER, TokenKind::INTEGER, 0, TokenKind::INTEGER};
+        case CharClass::BACKSLASH:
+            return {Action::ESCAPE, TokenKind::ESCAPED_CHARACTER, 0, TokenKind::ESCAPED_CHARACTER};
+        case CharClass::DOUBLE_QUOTE:
+            return {Action::QUOTE, TokenKind::DOUBLE_QUOTE, '"', TokenKind::DOUBLE_QUOTE};
+        case CharClass::SINGLE_QUOTE:
+            return {Action::QUOTE, TokenKind::SINGLE_QUOTE, '\'', TokenKind::SINGLE_QUOTE};
+        case CharClass::L_PAREN:
+            return {Action::SINGLE, TokenKind::LEFT_PARENTHESIS, 0, TokenKind::LEFT_PARENTHESIS};
+        case CharClass::R_PAREN:
+            return {Action::SINGLE, TokenKind::RIGHT_PARENTHESIS, 0, TokenKind::RIGHT_PARENTHESIS};
+        case CharClass::L_BRACKET:
+            return {Action::SINGLE, TokenKind::LEFT_BRACKET, 0, TokenKind::LEFT_BRACKET};
+        case CharClass::R_BRACKET:
+            return {Action::SINGLE, TokenKind::RIGHT_BRACKET, 0, TokenKind::RIGHT_BRACKET};
+        case CharClass::L_BRACE:
+            return {Action::SINGLE, TokenKind::LEFT_BRACE, 0, TokenKind::LEFT_BRACE};
+        case CharClass::R_BRACE:
+            return {Action::SINGLE, TokenKind::RIGHT_BRACE, 0, TokenKind::RIGHT_BRACE};
+        case CharClass::SEMICOLON:
+            return {Action::SINGLE, TokenKind::SEMICOLON, 0, TokenKind::SEMICOLON};
+        case CharClass::COMMA:
+            return {Action::SINGLE, TokenKind::COMMA, 0, TokenKind::COMMA};
+        case CharClass::EQUALS:
+            return {Action::PAIR, TokenKind::ASSIGNMENT, '=', TokenKind::BOOLEAN_EQUAL};
+        case CharClass::PLUS:
+            return {Action::SIGN, TokenKind::PLUS, 0, TokenKind::INTEGER};
+        case CharClass::MINUS:
+            return {Action::SIGN, TokenKind::MINUS, 0, TokenKind::INTEGER};
+        case CharClass::ASTERISK:
+            return {Action::SINGLE, TokenKind::ASTERISK, 0, TokenKind::ASTERISK};
+        case CharClass::SLASH:
+            return {Action::SINGLE, TokenKind::DIVIDE, 0, TokenKind::DIVIDE};
+        case CharClass::PERCENT:
+            return {Action::SINGLE, TokenKind::MODULO, 0, TokenKind::MODULO};
+        case CharClass::CARET:
+            return {Action::SINGLE, TokenKind::CARET, 0, TokenKind::CARET};
+        case CharClass::LESS:
+            return {Action::PAIR, TokenKind::LESS_THAN, '=', TokenKind::LESS_THAN_OR_EQUAL};
+        case CharClass::GREATER:
+            return {Action::PAIR, TokenKind::GREATER_THAN, '=', TokenKind::GREATER_THAN_OR_EQUAL};
+        case CharClass::AMPERSAND:
+            return {Action::PAIR_ONLY, TokenKind::BOOLEAN_AND, '&', TokenKind::BOOLEAN_AND};
+        case CharClass::BAR:
+            return {Action::PAIR_ONLY, TokenKind::BOOLEAN_OR, '|', TokenKind::BOOLEAN_OR};
+        case CharClass::EXCLAMATION:
+            return {Action::PAIR, TokenKind::BOOLEAN_NOT, '=', TokenKind::NOT_EQUAL};
+        default:
+            return {Action::DROP, TokenKind::IDENTIFIER, 0, TokenKind::IDENTIFIER};
+    }
+}
+
+/*
+    The class of every character, built when compiling. The class of
+    a character c (or EOF) is at c + 1.
+*/
+struct CharClassTable {
+    CharClass classes[257];
+
+    constexpr CharClassTable() : classes() {
+        for (int c = EOF; c < 256; c++) {
+            classes[c + 1] = classify(c);
+        }
+    }
+};
+
+/*
+    The transition of every class of characters, built when compiling.
+*/
+struct TransitionTable {
+    Transition transitions[static_cast<int>(CharClass::COUNT)];
+
+    constexpr TransitionTable() : transitions() {
+        for (int i = 0; i < static_cast<int>(CharClass::COUNT); i++) {
+            transitions[i] = transitionFor(static_cast<CharClass>(i));
+        }
+    }
+};
+
+static constexpr CharClassTable charClasses;
+static constexpr TransitionTable startTransitions;
+
+static_assert(EOF == -1, "charClasses expects EOF to be -1");
+
+/*
+    This function returns the class of a character that was read.
+*/
+static inline CharClass classOf(char c) {
+    return charClasses.classes[static_cast<unsigned char>(c) + 1];
+}
+
+/*
+    This function returns the class of a character that was peeked,
+    which can be EOF.
+*/
+static inline CharClass classOfPeek(int c) {
+    return charClasses.classes[c + 1];
+}
+
+/*
+    This function returns true if a class is whitespace.
+*/
+static inline bool isSpaceClass(CharClass charClass) {
+    return charClass == CharClass::NEWLINE || charClass == CharClass::SPACE ||
+           charClass == CharClass::OTHER_SPACE;
+}
+
+/*
+    This function returns true if a class can continue an identifier.
+*/
+static inline bool isIdentifierClass(CharClass charClass) {
+    return charClass == CharClass::LETTER || charClass == CharClass::DIGIT ||
+           charClass == CharClass::UNDERSCORE;
+}
+
+/*
+    A reserved word and the kind of token it is.
+*/
+struct Keyword {
+    const char* text;
+    TokenKind kind;
+};
+
+static constexpr Keyword keywords[] = {
+    {"int", TokenKind::KEYWORD_INT},
+    {"char", TokenKind::KEYWORD_CHAR},
+    {"bool", TokenKind::KEYWORD_BOOL},
+    {"void", TokenKind::KEYWORD_VOID},
+    {"if", TokenKind::KEYWORD_IF},
+    {"else", TokenKind::KEYWORD_ELSE},
+    {"function", TokenKind::KEYWORD_FUNCTION},
+    {"procedure", TokenKind::KEYWORD_PROCEDURE},
+    {"printf", TokenKind::KEYWORD_PRINTF}
+};
+
+static constexpr int keywordCount = sizeof(keywords) / sizeof(keywords[0]);
+static constexpr int keywordSlotCount = 16;
+
+/*
+    This function is a perfect hash of the reserved words, each of
+    them gets a slot of its own in keywordTable. It looks at the first
+    two characters and the length, so word has to have at least two
+    characters.
+*/
+constexpr unsigned int keywordHash(const char* word, std::size_t length) {
+    return (static_cast<unsigned char>(word[0]) * 2 +
+            static_cast<unsigned char>(word[1]) * 8 + length) % keywordSlotCount;
+}
+
+/*
+    This function returns the length of a reserved word.
+*/
+constexpr std::size_t keywordLength(const char* word) {
+    std::size_t length = 0;
+    while (word[length] != '\0') {
+        length++;
+    }
+    return length;
+}
+
+/*
+    The reserved word in each slot of the hash, built when compiling.
+    Empty slots hold -1. perfect is false if two reserved words hash
+    to the same slot.
+*/
+struct KeywordTable {
+    int slots[keywordSlotCount];
+    std::size_t lengths[keywordSlotCount];
+    bool perfect;
+
+    constexpr KeywordTable() : slots(), lengths(), perfect(true) {
+        for (int i = 0; i < keywordSlotCount; i++) {
+            slots[i] = -1;
+        }
+        for (int i = 0; i < keywordCount; i++) {
+            std::size_t length = keywordLength(keywords[i].text);
+            unsigned int slot = keywordHash(keywords[i].text, length);
+            if (slots[slot] != -1) {
+                perfect = false;
+            }
+            slots[slot] = i;
+            lengths[slot] = length;
+        }
+    }
+};
+
+static constexpr KeywordTable keywordTable;
+
+static_assert(keywordTable.perfect, "keywordHash must give every reserved word its own slot");
+
+/*
+    This function returns the kind of an identifier, which is the kind
+    of its reserved word if it is one.
+*/
+static TokenKind identifierKind(const std::string &word) {
+    if (word.size() < 2) {
+        return TokenKind::IDENTIFIER;
+    }
+
+    unsigned int slot = keywordHash(word.data(), word.size());
+    int keyword = keywordTable.slots[slot];
+    if (keyword != -1 && keywordTable.lengths[slot] == word.size() &&
+        std::memcmp(keywords[keyword].text, word.data(), word.size()) == 0) {
+        return keywords[keyword].kind;
+    }
+    return TokenKind::IDENTIFIER;
+}
+
+/*
+    This function converts the value of an INTEGER token to an int.
+    Values that don't fit in an int are clamped to the nearest one.
+*/
+static int parseInteger(const std::string &digits) {
+    bool negative = (digits[0] == '-');
+    long long result = 0;
+
+    for (std::size_t i = negative ? 1 : 0; i < digits.size(); i++) {
+        result = result * 10 + (digits[i] - '0');
+        if (result > static_cast<long long>(INT_MAX) + 1) {
+            result = static_cast<long long>(INT_MAX) + 1;
+        }
+    }
+
+    if (negative) {
+        return static_cast<int>(-result);
+    }
+    return (result > INT_MAX) ? INT_MAX : static_cast<int>(result);
+}
+
+/*
+    The default constructor initializes the variables declared
+    in the header file.
+*/
+Tokenization::Tokenization() {
+    token.kind = TokenKind::IDENTIFIER;
+    token.offset = 0;
+    token.length = 0;
+    token.integerValue = 0;
+    token.atom = AtomTable::none;
+    tokenValue = "";
+    source = nullptr;
+    sourceLength = 0;
+    invalidToken = false;
+    invalidType = "";
+    errorLineNumber = 0;
+    errorOffset = 0;
+    skippingComments = false;
+}
+
+/*
+    This function tokenizes the input file and stores the tokens
+    in a vector.
+*/
+void Tokenization::tokenize(const std::string &inputFilename) {
+    // check if input file exists, it stays open for the token values
+    if (!sourceFile.open(inputFilename)) {
+        std::cout << "Error: Unable to open input file to tokenize." << std::endl;
+        return;
+    }
+
+    tokenize(sourceFile.begin(), sourceFile.end());
+}
+
+/*
+    This function tokenizes source code that is already in memory,
+    such as the output of RemoveComments::removeCommentsFromSource.
+*/
+void Tokenization::tokenizeSource(const std::string &sourceCode) {
+    tokenize(sourceCode.data(), sourceCode.data() + sourceCode.size());
+}
+
+/*
+    This function walks the characters from begin to end and stores
+    the tokens that are found in a vector.
+*/
+void Tokenization::tokenize(const char* begin, const char* end) {
+    setSource(begin, end);
+    skippingComments = false;
+
+    SourceReader inFile(begin, end);
+    tokenizeToList(inFile);
+}
+
+/*
+    This function tokenizes source code that still has its comments.
+    The comments are skipped while reading, exactly as if the source
+    had been passed through RemoveComments first, so the source is
+    only read once and no copy of it is made.
+*/
+void Tokenization::tokenizeSkippingComments(const char* begin, const char* end) {
+    setSource(begin, end);
+    skippingComments = true;
+
+    SourceReader rawFile(begin, end);
+    CommentSkipper<SourceReader> inFile(rawFile);
+    inFile.recordErrors(&commentErrors);
+    tokenizeToList(inFile);
+
+    // report unterminated comments after an invalid token too
+    inFile.finish();
+    for (std::size_t i = 0; i < commentErrors.size(); i++) {
+        RemoveComments::unterminatedComment(commentErrors[i]);
+    }
+}
+
+/*
+    This function tokenizes a file without keeping all of it or all of
+    its tokens in memory. The file is read chunkSize characters at a
+    time and its comments are skipped while reading. Each token is
+    passed to consumer with its value as soon as it is found instead
+    of being stored in the token list, so memory use doesn't grow
+    with the file.
+*/
+void Tokenization::tokenizeStream(const std::string &inputFilename,
+                                  const std::function<void(const Token&, const std::string&)> &consumer,
+                                  std::size_t chunkSize) {
+    SourceStream rawFile(chunkSize);
+    setSource(nullptr, nullptr);
+
+    // check if input file exists
+    if (!rawFile.open(inputFilename)) {
+        std::cout << "Error: Unable to open input file to tokenize." << std::endl;
+        return;
+    }
+
+    CommentSkipper<SourceStream> inFile(rawFile);
+    tokenize(inFile, consumer);
+
+    // report unterminated comments after an invalid token too
+    inFile.finish();
+}
+
+/*
+    A Segment tokenizes the source from one of the newline boundaries
+    that tokenizeParallel splits it at, as if tokenizing started there:
+    on line 1, outside of any string or comment, with no token before.
+    It keeps going past the next boundary until it reaches a boundary
+    where that is true again, so the tokens of the segments that are
+    kept can be joined. Tab quirk: whitespace that repeats the last
+    token before any token of the segment is found is recorded in
+    leadingRepeats, since the token to repeat is in another segment.
+*/
+class Tokenization::Segment {
+    public:
+        Segment(const char* begin, const char* end, std::size_t start,
+                std::size_t boundaryIndex, bool skipComments);
+
+        void lexUntil(const std::vector<std::size_t> &boundaries, std::size_t lastIndex);
+        bool repeatsLastToken() const { return lexer.tokenValue == inheritedValue; }
+
+        // value of the token before the segment, no token has it
+        static const char* const inheritedValue;
+
+        // tokens, values and errors found in the segment
+        Tokenization lexer;
+        SourceReader rawFile;
+        CommentSkipper<SourceReader> commentSkipper;
+        bool skipComments;
+        LexerState state;
+        std::vector<unsigned int> leadingRepeats;
+        std::vector<int> commentErrors;
+        // boundary the segment ends at, or is headed to if it isn't finished
+        std::size_t endIndex;
+        bool finished;
+};
+
+const char* const Tokenization::Segment::inheritedValue = " ";
+
+/*
+    The Segment constructor starts reading at start, which is the
+    boundary at boundaryIndex.
+*/
+Tokenization::Segment::Segment(const char* begin, const char* end, std::size_t start,
+                               std::size_t boundaryIndex, bool skipComments) :
+    rawFile(begin, begin + start, end), commentSkipper(rawFile),
+    skipComments(skipComments), endIndex(boundaryIndex + 1), finished(false) {
+    lexer.setSource(begin, end);
+    commentSkipper.recordErrors(&commentErrors);
+
+    // the token to repeat isn't known yet
+    lexer.tokenValue = inheritedValue;
+}
+
+/*
+    This function tokenizes until a boundary is reached where no string
+    or comment is open, the end of the source or an invalid token. It
+    stops early, unfinished, once it passes the boundary at lastIndex.
+*/
+void Tokenization::Segment::lexUntil(const std::vector<std::size_t> &boundaries,
+                                     std::size_t lastIndex) {
+    std::size_t endOfSource = boundaries.back();
+
+    while (!finished) {
+        state.stopPosition = (endIndex + 1 < boundaries.size()) ?
+                             boundaries[endIndex] : static_cast<std::size_t>(-1);
+
+        bool foundToken = skipComments ? lexer.nextToken(commentSkipper, state) :
+                                         lexer.nextToken(rawFile, state);
+        if (foundToken) {
+            if (repeatsLastToken()) {
+                leadingRepeats.push_back(lexer.token.offset);
+            }
+            else {
+                lexer.addToken(lexer.token, lexer.tokenValue);
+            }
+            continue;
+        }
+
+        std::size_t position = skipComments ? commentSkipper.position() : rawFile.position();
+        if (lexer.invalidToken || position >= endOfSource) {
+            endIndex = boundaries.size() - 1;
+            finished = true;
+        }
+        else if (position == boundaries[endIndex] && state.endingQuote == 0 &&
+                 !state.closingQuote && (!skipComments || commentSkipper.atStart())) {
+            finished = true;
+        }
+        else {
+            // a string or comment is open, go on to the next boundary
+            while (boundaries[endIndex] <= position) {
+                endIndex++;
+            }
+            if (endIndex > lastIndex) {
+                return;
+            }
+        }
+    }
+}
+
+/*
+    This function tokenizes the source from begin to end on threadCount
+    threads (all of the cores if it is 0) and stores the tokens in the
+    token list, exactly as tokenize or tokenizeSkippingComments would.
+    The source is split after newlines into segments of about
+    segmentSize characters, and each segment is tokenized as if no
+    string or comment is open at its start. The segments are then
+    joined in order. When a segment ends inside a string or comment,
+    the segment before it has kept going past that point, so its
+    tokens are used instead of the next segment's.
+*/
+void Tokenization::tokenizeParallel(const char* begin, const char* end, bool skipComments,
+                                    unsigned int threadCount, std::size_t segmentSize) {
+    std::size_t length = end - begin;
+
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (segmentSize == 0) {
+        segmentSize = 1;
+    }
+
+    // split the source after newlines
+    std::vector<std::size_t> boundaries(1, 0);
+    while (length - boundaries.back() > segmentSize) {
+        const char* next = static_cast<const char*>(
+            std::memchr(begin + boundaries.back() + segmentSize, '\n',
+                        length - boundaries.back() - segmentSize));
+        if (!next || next + 1 == end) {
+            break;
+        }
+        boundaries.push_back(next + 1 - begin);
+    }
+    boundaries.push_back(length);
+
+    std::size_t segmentCount = boundaries.size() - 1;
+    if (threadCount == 1 || segmentCount < 2) {
+        if (skipComments) {
+            tokenizeSkippingComments(begin, end);
+        }
+        else {
+            tokenize(begin, end);
+        }
+        return;
+    }
+
+    setSource(begin, end);
+    skippingComments = skipComments;
+
+    // tokenize the segments, each one goes at most one boundary past its own
+    std::vector<std::unique_ptr<Segment>> segments(segmentCount);
+    std::vector<std::size_t> newlineCounts(segmentCount);
+    std::atomic<std::size_t> nextSegment(0);
+
+    auto work = [&]() {
+        for (std::size_t i = nextSegment++; i < segmentCount; i = nextSegment++) {
+            segments[i].reset(new Segment(begin, end, boundaries[i], i, skipComments));
+            segments[i]->lexUntil(boundaries, std::min(i + 2, segmentCount));
+            newlineCounts[i] = std::count(begin + boundaries[i], begin + boundaries[i + 1], '\n');
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < threadCount && i < segmentCount; i++) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (std::size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+
+    // join the segments that start where the one before ended
+    int commentLineOffset = 0;
+    std::size_t index = 0;
+    bool hasLastToken = false;
+    Token lastToken = token;
+
+    while (index < segmentCount) {
+        Segment &segment = *segments[index];
+        if (!segment.finished) {
+            segment.lexUntil(boundaries, segmentCount);
+        }
+        if (segment.lexer.invalidToken && skipComments) {
+            // report unterminated comments after an invalid token too
+            segment.commentSkipper.finish();
+        }
+
+        // an edit can start tokenizing again where the segment starts
+        Checkpoint checkpoint = {boundaries[index], tokenList.size(), hasLastToken};
+        checkpoints.push_back(checkpoint);
+
+        // whitespace at the start of the segment repeats the token before it
+        if (hasLastToken) {
+            for (std::size_t i = 0; i < segment.leadingRepeats.size(); i++) {
+                Token newToken = lastToken;
+                newToken.offset = segment.leadingRepeats[i];
+                spillValue(newToken, value(lastToken));
+                tokenList.push_back(newToken);
+            }
+        }
+
+        std::vector<unsigned int> atomMap = mapAtoms(segment.lexer.atoms);
+        for (std::size_t i = 0; i < segment.lexer.tokenList.size(); i++) {
+            tokenList.push_back(adoptToken(segment.lexer, segment.lexer.tokenList[i], atomMap));
+        }
+
+        // newlines in strings aren't counted
+        for (std::size_t i = 0; i < segment.lexer.sourceMap.skippedCount(); i++) {
+            sourceMap.skipNewline(segment.lexer.sourceMap.skippedAt(i));
+        }
+
+        for (std::size_t i = 0; i < segment.commentErrors.size(); i++) {
+            commentErrors.push_back(segment.commentErrors[i] + commentLineOffset);
+        }
+
+        if (segment.lexer.invalidToken) {
+            invalidToken = true;
+            invalidType = segment.lexer.invalidType;
+            errorOffset = segment.lexer.errorOffset;
+            errorLineNumber = sourceMap.line(errorOffset);
+            break;
+        }
+
+        // the token that whitespace in the next segment repeats
+        if (!segment.repeatsLastToken()) {
+            hasLastToken = (segment.lexer.tokenValue != "");
+            if (hasLastToken) {
+                lastToken = tokenList.back();
+            }
+        }
+
+        for (std::size_t i = index; i < segment.endIndex; i++) {
+            commentLineOffset += newlineCounts[i];
+        }
+        index = segment.endIndex;
+    }
+
+    for (std::size_t i = 0; i < commentErrors.size(); i++) {
+        RemoveComments::unterminatedComment(commentErrors[i]);
+    }
+}
+
+/*
+    This function returns the atoms in this tokenizer of the names in
+    another tokenizer's AtomTable, indexed by their atoms there.
+*/
+std::vector<unsigned int> Tokenization::mapAtoms(const AtomTable &otherAtoms) {
+    std::vector<unsigned int> atomMap(otherAtoms.size());
+    for (unsigned int atom = 0; atom < otherAtoms.size(); atom++) {
+        atomMap[atom] = atoms.intern(otherAtoms.data(atom), otherAtoms.length(atom));
+    }
+    return atomMap;
+}
+
+/*
+    This function returns a token that lexer found over the same source
+    as it is in this token list, with its atom from atomMap and its
+    value kept here if lexer kept it in its extraValues.
+*/
+Token Tokenization::adoptToken(const Tokenization &lexer, const Token &otherToken,
+                               const std::vector<unsigned int> &atomMap) {
+    Token newToken = otherToken;
+    if (newToken.atom != AtomTable::none) {
+        newToken.atom = atomMap[newToken.atom];
+    }
+    if (newToken.offset >= lexer.sourceLength) {
+        std::string valueText = lexer.value(newToken);
+        newToken.offset = lexer.location(newToken);
+        spillValue(newToken, valueText);
+    }
+    return newToken;
+}
+
+/*
+    The Resync struct compares the checkpoints that are reached while
+    the edited part of a source is tokenized again with the checkpoints
+    of the token list from before the edit. Old checkpoints after the
+    edit are at their position plus delta in the edited source.
+*/
+struct Tokenization::Resync {
+    // token list from before the edit
+    const Tokenization* previous;
+    // edit of the source, in offsets from before it
+    std::size_t editOffset;
+    std::size_t editEnd;
+    std::ptrdiff_t delta;
+
+    static const std::size_t none;
+
+    /*
+        This function returns the edited position of the first old
+        checkpoint after the edit that is past position.
+    */
+    std::size_t target(std::size_t position) const {
+        std::ptrdiff_t after = static_cast<std::ptrdiff_t>(position) - delta + 1;
+        std::size_t first = std::max(firstKept(), static_cast<std::size_t>(std::max<std::ptrdiff_t>(after, 0)));
+        std::size_t index = find(first);
+        if (index == previous->checkpoints.size()) {
+            return none;
+        }
+        return previous->checkpoints[index].position + delta;
+    }
+
+    /*
+        This function returns the index of the old checkpoint that is
+        the same as checkpoint, which lexer reached, or none. The old
+        tokens from there on are what lexer would find next.
+    */
+    std::size_t match(const Checkpoint &checkpoint, const Tokenization &lexer) const {
+        std::ptrdiff_t oldPosition = static_cast<std::ptrdiff_t>(checkpoint.position) - delta;
+        if (oldPosition < static_cast<std::ptrdiff_t>(firstKept())) {
+            return none;
+        }
+        std::size_t index = find(oldPosition);
+        if (index == previous->checkpoints.size() ||
+            previous->checkpoints[index].position != static_cast<std::size_t>(oldPosition) ||
+            previous->checkpoints[index].repeatable != checkpoint.repeatable) {
+            return none;
+        }
+
+        // whitespace after the checkpoint has to repeat the same token
+        if (checkpoint.repeatable) {
+            const Token &oldToken = previous->tokenList[previous->checkpoints[index].tokenIndex - 1];
+            if (oldToken.kind != lexer.token.kind || oldToken.length != lexer.tokenValue.size() ||
+                !oldValueIs(oldToken, lexer)) {
+                return none;
+            }
+        }
+        return index;
+    }
+
+    /*
+        This function returns the first old position a checkpoint can
+        be kept from. A checkpoint at an insertion is the one the
+        tokens are found again from, so it can't be kept.
+    */
+    std::size_t firstKept() const {
+        return std::max(editEnd, editOffset + 1);
+    }
+
+    /*
+        This function returns the index of the first old checkpoint at
+        or after position.
+    */
+    std::size_t find(std::size_t position) const {
+        const std::vector<Checkpoint> &checkpoints = previous->checkpoints;
+        std::size_t low = 0;
+        std::size_t high = checkpoints.size();
+        while (low < high) {
+            std::size_t middle = (low + high) / 2;
+            if (checkpoints[middle].position < position) {
+                low = middle + 1;
+            }
+            else {
+                high = middle;
+            }
+        }
+        return low;
+    }
+
+    /*
+        This function returns true if the value of an old token is the
+        value of the token lexer found last. The old source is gone, so
+        the value is read from the edited source, where a token that
+        overlapped the edit can't be found.
+    */
+    bool oldValueIs(const Token &oldToken, const Tokenization &lexer) const {
+        const std::string &valueText = lexer.tokenValue;
+        if (oldToken.offset >= previous->sourceLength) {
+            return previous->extraValues.compare(oldToken.offset - previous->sourceLength,
+                                                 oldToken.length, valueText) == 0;
+        }
+
+        std::size_t offset = oldToken.offset;
+        if (offset >= editEnd) {
+            offset += delta;
+        }
+        else if (offset + oldToken.length > editOffset) {
+            return false;
+        }
+        return std::memcmp(lexer.source + offset, valueText.data(), valueText.size()) == 0;
+    }
+};
+
+const std::size_t Tokenization::Resync::none = static_cast<std::size_t>(-1);
+const std::size_t Tokenization::checkpointSpacing;
+
+/*
+    This function updates the token list after removedLength characters
+    at offset in sourceCode are replaced with insertedText, and makes
+    the edit to sourceCode. Only the tokens from the last checkpoint
+    before the edit are found again, until a checkpoint after the edit
+    is reached in the same state as before. The tokens after it are
+    kept and moved. The token list has to be made by tokenize,
+    tokenizeSkippingComments or tokenizeParallel for sourceCode,
+    otherwise the whole source is tokenized again.
+*/
+void Tokenization::edit(std::string &sourceCode, std::size_t offset, std::size_t removedLength,
+                        const std::string &insertedText) {
+    std::size_t oldLength = sourceLength;
+    int lineDelta = static_cast<int>(CharScan::count(insertedText.data(),
+                                                     insertedText.data() + insertedText.size(), '\n')) -
+                    static_cast<int>(CharScan::count(sourceCode.data() + offset,
+                                                     sourceCode.data() + offset + removedLength, '\n'));
+    sourceCode.replace(offset, removedLength, insertedText);
+    const char* begin = sourceCode.data();
+    const char* end = begin + sourceCode.size();
+
+    // the source before the edit is the same, but may have moved
+    source = begin;
+
+    // tokens after an invalid token were never found
+    if (checkpoints.empty() || invalidToken || begin == end) {
+        clearTokens();
+        if (skippingComments) {
+            tokenizeSkippingComments(begin, end);
+        }
+        else {
+            tokenize(begin, end);
+        }
+        return;
+    }
+
+    Resync resync;
+    resync.previous = this;
+    resync.editOffset = offset;
+    resync.editEnd = offset + removedLength;
+    resync.delta = static_cast<std::ptrdiff_t>(insertedText.size()) -
+                   static_cast<std::ptrdiff_t>(removedLength);
+
+    // start again at the last checkpoint at or before the edit
+    std::size_t restartIndex = resync.find(offset + 1) - 1;
+    const Checkpoint restart = checkpoints[restartIndex];
+
+    sourceMap.edit(begin, end, offset, removedLength, insertedText.size());
+
+    Tokenization lexer;
+    lexer.setSource(begin, end);
+    if (restart.repeatable) {
+        lexer.token = tokenList[restart.tokenIndex - 1];
+        lexer.tokenValue = value(lexer.token);
+        // a repeat of the token is given its atom by storeValue, as the
+        // token being read has none while tokenizing from the start
+        lexer.token.atom = AtomTable::none;
+    }
+
+    LexerState state;
+    SourceReader rawFile(begin, begin + restart.position, end);
+    std::size_t resyncIndex;
+    if (skippingComments) {
+        CommentSkipper<SourceReader> inFile(rawFile,
+                                            static_cast<int>(sourceMap.newlinesBefore(restart.position)) + 1);
+        inFile.recordErrors(&lexer.commentErrors);
+        resyncIndex = lexer.readTokens(inFile, state, &resync);
+        if (lexer.invalidToken) {
+            // report unterminated comments after an invalid token too
+            inFile.finish();
+        }
+        for (std::size_t i = 0; i < lexer.commentErrors.size(); i++) {
+            RemoveComments::unterminatedComment(lexer.commentErrors[i]);
+        }
+    }
+    else {
+        resyncIndex = lexer.readTokens(rawFile, state, &resync);
+    }
+
+    // the old tokens and checkpoints from resyncIndex on are kept
+    std::size_t keptToken = tokenList.size();
+    std::size_t keptPosition = oldLength;
+    if (resyncIndex != Resync::none) {
+        keptToken = checkpoints[resyncIndex].tokenIndex;
+        keptPosition = checkpoints[resyncIndex].position;
+    }
+    else {
+        resyncIndex = checkpoints.size();
+    }
+
+    // move the kept tokens, values that are kept in extraValues move
+    // with the end of the source
+    source = begin;
+    sourceLength = end - begin;
+    std::size_t firstMoved = extraValues.empty() ? keptToken : 0;
+    for (std::size_t i = firstMoved; i < tokenList.size(); i++) {
+        if (tokenList[i].offset >= oldLength) {
+            tokenList[i].offset = tokenList[i].offset - oldLength + sourceLength;
+        }
+        else if (i >= keptToken) {
+            tokenList[i].offset += resync.delta;
+        }
+    }
+    for (std::size_t i = 0; i < extraLocations.size(); i++) {
+        if (extraLocations[i].second >= resync.editEnd) {
+            extraLocations[i].second += resync.delta;
+        }
+    }
+
+    // put the new tokens in place of the old ones
+    std::vector<unsigned int> atomMap = mapAtoms(lexer.atoms);
+    std::vector<Token> newTokens;
+    newTokens.reserve(lexer.tokenList.size());
+    for (std::size_t i = 0; i < lexer.tokenList.size(); i++) {
+        newTokens.push_back(adoptToken(lexer, lexer.tokenList[i], atomMap));
+    }
+    std::size_t removedTokens = keptToken - restart.tokenIndex;
+    if (newTokens.size() > removedTokens) {
+        tokenList.insert(tokenList.begin() + keptToken, newTokens.size() - removedTokens, Token());
+    }
+    else {
+        tokenList.erase(tokenList.begin() + restart.tokenIndex + newTokens.size(),
+                        tokenList.begin() + keptToken);
+    }
+    std::copy(newTokens.begin(), newTokens.end(), tokenList.begin() + restart.tokenIndex);
+
+    std::ptrdiff_t tokenDelta = static_cast<std::ptrdiff_t>(newTokens.size()) -
+                                static_cast<std::ptrdiff_t>(removedTokens);
+    for (std::size_t i = resyncIndex; i < checkpoints.size(); i++) {
+        checkpoints[i].position += resync.delta;
+        checkpoints[i].tokenIndex += tokenDelta;
+    }
+    for (std::size_t i = 0; i < lexer.checkpoints.size(); i++) {
+        lexer.checkpoints[i].tokenIndex += restart.tokenIndex;
+    }
+    checkpoints.erase(checkpoints.begin() + restartIndex + 1, checkpoints.begin() + resyncIndex);
+    checkpoints.insert(checkpoints.begin() + restartIndex + 1,
+                       lexer.checkpoints.begin(), lexer.checkpoints.end());
+
+    sourceMap.replaceSkipped(restart.position, keptPosition + resync.delta, lexer.sourceMap);
+
+    // the comment errors before the restart are kept, and the ones
+    // after the kept position move down by the lines that were added
+    if (!commentErrors.empty() || !lexer.commentErrors.empty()) {
+        int restartLine = static_cast<int>(sourceMap.newlinesBefore(restart.position)) + 1;
+        int keptLine = static_cast<int>(sourceMap.newlinesBefore(keptPosition + resync.delta)) + 1 -
+                       lineDelta;
+        std::vector<int> errors;
+        std::size_t i = 0;
+        for (; i < commentErrors.size() && commentErrors[i] < restartLine; i++) {
+            errors.push_back(commentErrors[i]);
+        }
+        errors.insert(errors.end(), lexer.commentErrors.begin(), lexer.commentErrors.end());
+        if (keptPosition < oldLength) {
+            for (; i < commentErrors.size(); i++) {
+                if (commentErrors[i] >= keptLine) {
+                    errors.push_back(commentErrors[i] + lineDelta);
+                }
+            }
+        }
+        commentErrors.swap(errors);
+    }
+
+    if (lexer.invalidToken) {
+        invalidToken = true;
+        invalidType = lexer.invalidType;
+        errorOffset = lexer.errorOffset;
+        errorLineNumber = sourceMap.line(errorOffset);
+    }
+}
+
+/*
+    This function forgets the tokens that were found, so the source
+    can be tokenized again.
 */
-Tokenization::Tokenization() {
-    token.type = "";
-    token.value = "";
+void Tokenization::clearTokens() {
+    tokenList.clear();
+    extraValues.clear();
+    extraLocations.clear();
+    checkpoints.clear();
+    commentErrors.clear();
+    token.kind = TokenKind::IDENTIFIER;
+    token.offset = 0;
+    token.length = 0;
+    token.integerValue = 0;
+    token.atom = AtomTable::none;
+    tokenValue = "";
     invalidToken = false;
     invalidType = "";
     errorLineNumber = 0;
+    errorOffset = 0;
 }
 
 /*
-    This function tokenizes the input file and stores the tokens
-    in a vector.
+    This function reads characters from inFile and passes each token
+    that is found to consumer along with its value. inFile is a
+    SourceReader, SourceStream or CommentSkipper.
 */
-void Tokenization::tokenize(const std::string &inputFilename) {
-    std::ifstream inFile(inputFilename);
-
-    // check if input file exists
-    if (!inFile) {
-        std::cout << "Error: Unable to open input file to tokenize." << std::endl;
+template <typename Reader, typename Consumer>
+void Tokenization::tokenize(Reader &inFile, const Consumer &consumer) {
+    // check if input file is empty
+    if (inFile.peek() == EOF) {
+        std::cout << "Input file is empty." << std::endl;
         return;
     }
 
+    LexerState state;
+    while (nextToken(inFile, state)) {
+        consumer(token, tokenValue);
+    }
+}
+
+/*
+    This function reads characters from inFile and stores the tokens
+    that are found in the token list, with a checkpoint at the start.
+*/
+template <typename Reader>
+void Tokenization::tokenizeToList(Reader &inFile) {
     // check if input file is empty
     if (inFile.peek() == EOF) {
         std::cout << "Input file is empty." << std::endl;
         return;
     }
 
-    // set start state
-    BNF currentState = BNF::START;
+    Checkpoint start = {inFile.position(), tokenList.size(), false};
+    checkpoints.push_back(start);
+
+    LexerState state;
+    readTokens(inFile, state, nullptr);
+}
+
+/*
+    This function adds the tokens read from inFile to the token list
+    until the end of the source or an invalid token. About every
+    checkpointSpacing characters it stops at the start of a line, and
+    if no string or comment is open there, a checkpoint is added. When
+    an edit is tokenized again, it also stops at the old checkpoints
+    after the edit, and returns the index of the first one that is
+    reached in the same state, or Resync::none.
+*/
+template <typename Reader>
+std::size_t Tokenization::readTokens(Reader &inFile, LexerState &state, const Resync *resync) {
+    std::size_t target = nextLineStart(inFile.position() + checkpointSpacing);
+
+    while (true) {
+        if (resync) {
+            target = std::min(target, resync->target(inFile.position()));
+        }
+        state.stopPosition = target;
+        while (nextToken(inFile, state)) {
+            addToken(token, tokenValue);
+        }
+
+        std::size_t position = inFile.position();
+        if (invalidToken || position >= sourceLength) {
+            return Resync::none;
+        }
+
+        if (position == target && state.endingQuote == 0 && !state.closingQuote &&
+            inFile.atStart()) {
+            Checkpoint checkpoint = {position, tokenList.size(), tokenValue != ""};
+            if (resync) {
+                std::size_t index = resync->match(checkpoint, *this);
+                if (index != Resync::none) {
+                    return index;
+                }
+            }
+            checkpoints.push_back(checkpoint);
+            target = nextLineStart(position + checkpointSpacing);
+        }
+        else {
+            target = nextLineStart(position);
+        }
+    }
+}
+
+/*
+    This function returns the offset of the first line that starts
+    after from, or none if there isn't one.
+*/
+std::size_t Tokenization::nextLineStart(std::size_t from) const {
+    if (from >= sourceLength) {
+        return Resync::none;
+    }
+    const char* newline = CharScan::findAny(source + from, source + sourceLength,
+                                            '\n', '\n', '\n', '\n');
+    if (newline == source + sourceLength) {
+        return Resync::none;
+    }
+    return newline - source + 1;
+}
 
+/*
+    This function reads the next token from inFile into token and
+    tokenValue, and returns false when there are no more tokens or
+    an invalid token was found. state keeps what is needed to carry
+    on from the same place in the next call. The first character of
+    a token is looked up in the charClasses and startTransitions
+    tables, and the rest of the token is read right away, so no
+    character is put back and read a second time.
+*/
+template <typename Reader>
+bool Tokenization::nextToken(Reader &inFile, LexerState &state) {
     // variables needed for switch case
     char currentChar;
-    bool doubleQuoteStart = true;
-    bool singleQuoteStart = true;
-    char endingQuote;
-    int lineNumber = 1;
-    
-    // get tokens 
-    while (inFile.get(currentChar) && !invalidToken) {
-        if (currentChar == '\n') {
-            lineNumber++;
-            continue;
+    std::size_t charPosition;
+
+    // set the current token
+    auto found = [&](TokenKind kind) {
+        token.kind = kind;
+        token.length = tokenValue.size();
+        return true;
+    };
+
+    // the closing quote of the string that was found last time
+    if (state.closingQuote) {
+        state.closingQuote = false;
+        tokenValue = state.endingQuote;
+        token.offset = state.closingQuotePosition;
+        token.integerValue = 0;
+        state.endingQuote = 0;
+        return found(tokenValue[0] == '"' ? TokenKind::DOUBLE_QUOTE : TokenKind::SINGLE_QUOTE);
+    }
+
+    // get tokens
+    while (!invalidToken) {
+        // offset of currentChar in the source
+        charPosition = inFile.position();
+        if (charPosition >= state.stopPosition || !inFile.get(currentChar)) {
+            break;
         }
-        else if (currentChar == ' ') {
-            continue; // skip spaces
+
+        CharClass charClass = classOf(currentChar);
+        if (charClass == CharClass::NEWLINE || charClass == CharClass::SPACE) {
+            continue; // skip spaces and newlines
         }
-    
-        switch (currentState) {
-            case BNF::START:
-                // determine state based on current character
-                if (currentChar == '\\') {
-                    currentState = BNF::ESCAPED_CHARACTER;
-                }
-                else if (currentChar == '(') {
-                    currentState = BNF::L_PAREN;
-                }
-                else if (currentChar == ')') {
-                    currentState = BNF::R_PAREN;
-                }
-                else if (currentChar == '[') {
-                    currentState = BNF::L_BRACKET;
-                }
-                else if (currentChar == ']') {
-                    currentState = BNF::R_BRACKET;
-                }
-                else if (currentChar == '{') {
-                    currentState = BNF::L_BRACE;
-                }
-                else if (currentChar == '}') {
-                    currentState = BNF::R_BRACE;
-                }
-                else if (currentChar == '\"') {
-                    currentState = BNF::DOUBLE_QUOTE;
-                }
-                else if (currentChar == '\'') {
-                    currentState = BNF::SINGLE_QUOTE;
-                }
-                else if (currentChar == ';') {
-                    currentState = BNF::SEMICOLON;
-                }
-                else if (currentChar == ',') {
-                    currentState = BNF::COMMA;
-                }
-                else if (currentChar == '=') {
-                    if (inFile.peek() == '=') {
-                        currentState = BNF::BOOLEAN_EQUAL;
-                    }
-                    else {
-                        currentState = BNF::ASSIGNMENT_OPERATOR;
-                    }
-                }
-                else if (currentChar == '+') {
-                    if (isdigit(inFile.peek())) {
-                        currentState = BNF::INTEGER;
-                    }
-                    else {
-                        currentState = BNF::PLUS;
-                    }
-                }
-                else if (currentChar == '-') {
-                    if (isdigit(inFile.peek())) {
-                        currentState = BNF::INTEGER;
-                    }
-                    else {
-                        currentState = BNF::MINUS;
-                    }
-                }
-                else if (currentChar == '*') {
-                    currentState = BNF::ASTERISK;
-                }
-                else if (currentChar == '/') {
-                    currentState = BNF::DIVIDE;
-                }
-                else if (currentChar == '%') {
-                    currentState = BNF::MODULO;
-                }
-                else if (currentChar == '^') {
-                    currentState = BNF::CARET;
-                }
-                else if (currentChar == '<') {
-                    if (inFile.peek() == '=') {
-                        currentState = BNF::LT_EQUAL;
-                    }
-                    else {
-                        currentState = BNF::LT;
-                    }
-                }
-                else if (currentChar == '>') {
-                    if (inFile.peek() == '=') {
-                        currentState = BNF::GT_EQUAL;
-                    }
-                    else {
-                        currentState = BNF::GT;
-                    }
-                }
-                else if (currentChar == '&') {
-                    if (inFile.peek() == '&') {
-                        currentState = BNF::BOOLEAN_AND;
-                    }
-                }
-                else if (currentChar == '|') {
-                    if (inFile.peek() == '|') {
-                        currentState = BNF::BOOLEAN_OR;
-                    }
-                }
-                else if (currentChar == '!') {
-                    if (inFile.peek() == '=') {
-                        currentState = BNF::BOOLEAN_NOT_EQUAL;
-                    }
-                    else {
-                        currentState = BNF::BOOLEAN_NOT;
-                    }
-                }
-                else if (isdigit(currentChar)) {
-                    currentState = BNF::INTEGER;
-                }
-                else if (isalpha(currentChar)) {
-                    currentState = BNF::IDENTIFIER;
-                }
-                else {
-                    currentState = BNF::START;
-                }
-                
-                // return character (if not space) for updated switch case
-                if (!isspace(currentChar)) {
-                    token.value = ""; // clear token value
-                    inFile.putback(currentChar);
+
+        // read the string after an opening quote, then its closing quote
+        if (state.endingQuote != 0) {
+            tokenValue = "";
+            token.offset = charPosition;
+
+            while (currentChar != state.endingQuote) {
+                tokenValue += currentChar;
+                if (currentChar == '\n') {
+                    sourceMap.skipNewline(charPosition);
                 }
-                
-                
-                break;
-            case BNF::ESCAPED_CHARACTER:
-                token.type = "ESCAPED_CHARACTER";
-                while (!isspace(currentChar)) {
-                    token.value += currentChar;
+
+                // if there is an escaped quote get it
+                if (currentChar == '\\' && inFile.peek() != EOF) {
+                    charPosition = inFile.position();
                     inFile.get(currentChar);
+                    tokenValue += currentChar;
+                    if (currentChar == '\n') {
+                        sourceMap.skipNewline(charPosition);
+                    }
                 }
-                currentState = BNF::START;
-                break;
-            case BNF::L_PAREN:
-                token.type = "LEFT_PARENTHESIS";
-                token.value = currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::R_PAREN:
-                token.type = "RIGHT_PARENTHESIS";
-                token.value = currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::L_BRACKET:
-                token.type = "LEFT_BRACKET";
-                token.value = currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::R_BRACKET:
-                token.type = "RIGHT_BRACKET";
-                token.value = currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::L_BRACE:
-                token.type = "LEFT_BRACE";
-                token.value = currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::R_BRACE:
-                token.type = "RIGHT_BRACE";
-                token.value = currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::DOUBLE_QUOTE:
-                token.type = "DOUBLE_QUOTE";
-                token.value = currentChar;
-
-                // determine if starting quote
-                if (doubleQuoteStart) {
-                    doubleQuoteStart = false;
-                    // read in string
-                    currentState = BNF::STRING;
-                }
-                else {
-                    doubleQuoteStart = true;
-                    currentState = BNF::START;
-                }
-                break;
-            case BNF::SINGLE_QUOTE:
-                token.type = "SINGLE_QUOTE";
-                token.value = currentChar;
-
-                // determine if starting quote
-                if (singleQuoteStart) {
-                    singleQuoteStart = false;
-                    // read in string
-                    currentState = BNF::STRING;
-                }
-                else {
-                    singleQuoteStart = true;
-                    currentState = BNF::START;
+
+                // if we reach eof then there is an error
+                if (inFile.peek() == EOF) {
+                    setError(inFile, "string");
+                    break;
                 }
-                break;
-            case BNF::SEMICOLON:
-                token.type = "SEMICOLON";
-                token.value = currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::COMMA:
-                token.type = "COMMA";
-                token.value = currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::ASSIGNMENT_OPERATOR:
-                token.type = "ASSIGNMENT";
-                token.value = currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::PLUS:
-                token.type = "PLUS";
-                token.value = currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::MINUS:
-                token.type = "MINUS";
-                token.value = currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::ASTERISK:
-                token.type = "ASTERISK";
-                token.value = currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::DIVIDE:
-                token.type = "DIVIDE";
-                token.value = currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::MODULO:
-                token.type = "MODULO";
-                token.value = currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::CARET:
-                token.type = "CARET";
-                token.value = currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::LT:
-                token.type = "LESS_THAN";
-                token.value = currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::GT:
-                token.type = "GREATER_THAN";
-                token.value = currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::LT_EQUAL:
-                token.type = "LESS_THAN_OR_EQUAL";
-                token.value += currentChar;
-                // get =
-                inFile.get(currentChar);
-                token.value += currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::GT_EQUAL:
-                token.type = "GREATER_THAN_OR_EQUAL";
-                token.value += currentChar;
-                // get =
-                inFile.get(currentChar);
-                token.value += currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::BOOLEAN_AND:
-                token.type = "BOOLEAN_AND";
-                token.value += currentChar;
-                // get second &
-                inFile.get(currentChar);
-                token.value += currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::BOOLEAN_OR:
-                token.type = "BOOLEAN_OR";
-                token.value += currentChar;
-                // get second |
-                inFile.get(currentChar);
-                token.value += currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::BOOLEAN_NOT:
-                token.type = "BOOLEAN_NOT";
-                token.value = currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::BOOLEAN_EQUAL:
-                token.type = "BOOLEAN_EQUAL";
-                token.value += currentChar;
-                // get second equals sign
-                inFile.get(currentChar);
-                token.value += currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::BOOLEAN_NOT_EQUAL:
-                token.type = "NOT_EQUAL";
-                token.value += currentChar;
-                // get equal sign
+
+                charPosition = inFile.position();
                 inFile.get(currentChar);
-                token.value += currentChar;
-                currentState = BNF::START;
-                break;
-            case BNF::STRING:
-                token.type = "STRING";
-                
-                // set ending quote based on starting quote
-                if (!doubleQuoteStart) {
-                    endingQuote = '"';
-                }
-                else if (!singleQuoteStart) {
-                    endingQuote = '\'';
-                }
-                
-                // clear token value that holds beginning quote
-                token.value = "";
-                
-                while (currentChar != endingQuote) {
-                    token.value += currentChar;
-
-                    // if there is an escaped quote get it
-                    if (currentChar == '\\') {
-                        inFile.get(currentChar);
-                        token.value += currentChar;
-                    }
+            }
 
-                    // if we reach eof then there is an error
-                    if (inFile.peek() == EOF) {
-                        invalidToken = true;
-                        invalidType = "string";
-                        errorLineNumber = lineNumber;
-                        break;
-                    }
-                    
+            if (!invalidToken) {
+                state.closingQuote = true;
+                state.closingQuotePosition = charPosition;
+            }
+
+            if (tokenValue != "") {
+                return found(TokenKind::STRING);
+            }
+            return nextToken(inFile, state);
+        }
+
+        const Transition &transition = startTransitions.transitions[static_cast<int>(charClass)];
+
+        // other whitespace repeats the last token on this line, the
+        // repeat is located at the whitespace
+        if (transition.action == Action::REPEAT) {
+            if (tokenValue != "") {
+                token.offset = charPosition;
+                return found(token.kind);
+            }
+            continue;
+        }
+
+        tokenValue = currentChar;
+        token.offset = charPosition;
+        token.integerValue = 0;
+
+        switch (transition.action) {
+            case Action::SINGLE:
+                return found(transition.kind);
+            case Action::PAIR:
+                if (inFile.peek() == transition.second) {
                     inFile.get(currentChar);
+                    tokenValue += currentChar;
+                    return found(transition.pairKind);
                 }
-                // put back the ending quote
-                inFile.putback(currentChar);
-                
-                // change state back to quote type
-                if (!doubleQuoteStart) {
-                    currentState = BNF::DOUBLE_QUOTE;
-                }
-                else if (!singleQuoteStart) {
-                    currentState = BNF::SINGLE_QUOTE;
+                return found(transition.kind);
+            case Action::PAIR_ONLY:
+                if (inFile.peek() == transition.second) {
+                    inFile.get(currentChar);
+                    tokenValue += currentChar;
+                    return found(transition.pairKind);
                 }
+                tokenValue = ""; // a lone & or | is skipped
                 break;
-            case BNF::INTEGER:
-                token.type = "INTEGER";
-                if (currentChar == '-') {
-                    token.value += currentChar;
+            case Action::QUOTE:
+                state.endingQuote = transition.second;
+                return found(transition.kind);
+            case Action::ESCAPE:
+                // read up to the next space, the space is skipped too
+                while (!isSpaceClass(classOfPeek(inFile.peek())) &&
+                       inFile.peek() != EOF) {
                     inFile.get(currentChar);
+                    tokenValue += currentChar;
                 }
-                else if (currentChar == '+') {
-                    inFile.get(currentChar);
+                // a newline that is skipped isn't counted
+                charPosition = inFile.position();
+                if (inFile.get(currentChar) && currentChar == '\n') {
+                    sourceMap.skipNewline(charPosition);
+                }
+                return found(transition.kind);
+            case Action::SIGN:
+                if (classOfPeek(inFile.peek()) != CharClass::DIGIT) {
+                    return found(transition.kind);
+                }
+                // a leading - is part of the value, a leading + is not
+                if (currentChar == '+') {
+                    tokenValue = "";
+                    token.offset = inFile.position();
                 }
-                
-                while (isdigit(currentChar)) {
-                    token.value += currentChar;
+                // fall through to read the digits
+            case Action::INTEGER:
+                while (classOfPeek(inFile.peek()) == CharClass::DIGIT) {
                     inFile.get(currentChar);
+                    tokenValue += currentChar;
                 }
-                // if while loop ends on a char
-                if (isalpha(currentChar)) {
-                    invalidToken = true;
-                    invalidType = "integer";
-                    errorLineNumber = lineNumber;
+                // if digits end on a char
+                if (classOfPeek(inFile.peek()) == CharClass::LETTER) {
+                    setError(inFile, "integer");
                 }
-                // put back char that isn't digit
-                inFile.putback(currentChar);
-                currentState = BNF::START;
-                break;
-            case BNF::IDENTIFIER:
-                token.type = "IDENTIFIER";
-                while (isalnum(currentChar) || currentChar == '_') {
-                    token.value += currentChar;
+                token.integerValue = parseInteger(tokenValue);
+                return found(TokenKind::INTEGER);
+            case Action::IDENTIFIER:
+                while (isIdentifierClass(classOfPeek(inFile.peek()))) {
                     inFile.get(currentChar);
+                    tokenValue += currentChar;
                 }
-                // put back char that isn't alphanumeric
-                inFile.putback(currentChar);
-                currentState = BNF::START;
+                return found(identifierKind(tokenValue));
+            default:
+                // characters that can't start a token are skipped
+                tokenValue = "";
                 break;
         }
-        // add token to list only if token has a type
-        if (token.value != "") {
-            token.lineNumber = lineNumber;
-            tokenList.push_back(token);
-        }
     }
+    return false;
+}
+
+/*
+    This function adds a token to the token list, see storeValue.
+*/
+void Tokenization::addToken(const Token &newToken, const std::string &valueText) {
+    tokenList.push_back(newToken);
+    storeValue(tokenList.back(), valueText);
+}
+
+/*
+    This function gives a token the atom of its name if it is an
+    identifier or reserved word, and no atom otherwise. The token only keeps the offset of
+    its value in the source, unless the value isn't in the source as
+    it is (a string with a comment blanked out inside it). Then the
+    value is kept in extraValues, and the token's offset points past
+    the end of the source.
+*/
+void Tokenization::storeValue(Token &newToken, const std::string &valueText) {
+    // identifiers and reserved words are kinds from IDENTIFIER on
+    if (newToken.kind >= TokenKind::IDENTIFIER) {
+        newToken.atom = atoms.intern(valueText);
+    }
+    else {
+        newToken.atom = AtomTable::none;
+    }
+
+    if (newToken.offset + valueText.size() > sourceLength ||
+        std::memcmp(source + newToken.offset, valueText.data(), valueText.size()) != 0) {
+        spillValue(newToken, valueText);
+    }
+}
+
+/*
+    This function keeps the value of a token in extraValues, and
+    remembers the token's offset as its location in the source.
+*/
+void Tokenization::spillValue(Token &newToken, const std::string &valueText) {
+    extraLocations.push_back(std::make_pair(static_cast<unsigned int>(extraValues.size()),
+                                            newToken.offset));
+    newToken.offset = sourceLength + extraValues.size();
+    extraValues += valueText;
+}
+
+/*
+    This function returns where a token is in the source. That is its
+    offset, unless its value is kept in extraValues.
+*/
+std::size_t Tokenization::location(const Token &token) const {
+    if (token.offset < sourceLength) {
+        return token.offset;
+    }
+    std::pair<unsigned int, unsigned int> extra(token.offset - sourceLength, 0);
+    return std::lower_bound(extraLocations.begin(), extraLocations.end(), extra)->second;
+}
+
+/*
+    This function sets the source that the token offsets refer to.
+*/
+void Tokenization::setSource(const char* begin, const char* end) {
+    source = begin;
+    sourceLength = end - begin;
+    sourceMap.reset(begin, end);
+}
+
+/*
+    This function records an invalid token at the current token. Its
+    line is 1 plus the newlines read so far that are counted, since
+    the newlines in the token itself are never counted.
+*/
+template <typename Reader>
+void Tokenization::setError(Reader &inFile, const char* type) {
+    invalidToken = true;
+    invalidType = type;
+    errorOffset = token.offset;
+    errorLineNumber = static_cast<int>(1 + inFile.newlineCount() - sourceMap.skippedCount());
+}
+
+/*
+    This function returns the value of a token in the token list or
+    from a TokenStream.
+*/
+std::string Tokenization::value(const Token &token) const {
+    if (token.offset < sourceLength) {
+        return std::string(source + token.offset, token.length);
+    }
+    return extraValues.substr(token.offset - sourceLength, token.length);
+}
+
+/*
+    This function returns the name of a token kind as it is displayed.
+    Reserved words are displayed as identifiers.
+*/
+const char* Tokenization::kindName(TokenKind kind) {
+    static const char* const names[] = {
+        "ESCAPED_CHARACTER", "LEFT_PARENTHESIS", "RIGHT_PARENTHESIS",
+        "LEFT_BRACKET", "RIGHT_BRACKET", "LEFT_BRACE", "RIGHT_BRACE",
+        "DOUBLE_QUOTE", "SINGLE_QUOTE", "SEMICOLON", "COMMA", "ASSIGNMENT",
+        "PLUS", "MINUS", "ASTERISK", "DIVIDE", "MODULO", "CARET",
+        "LESS_THAN", "GREATER_THAN", "LESS_THAN_OR_EQUAL",
+        "GREATER_THAN_OR_EQUAL", "BOOLEAN_AND", "BOOLEAN_OR", "BOOLEAN_NOT",
+        "BOOLEAN_EQUAL", "NOT_EQUAL", "STRING", "INTEGER", "IDENTIFIER",
+        "IDENTIFIER", "IDENTIFIER", "IDENTIFIER", "IDENTIFIER", "IDENTIFIER",
+        "IDENTIFIER", "IDENTIFIER", "IDENTIFIER", "IDENTIFIER"
+    };
+    return names[static_cast<int>(kind)];
+}
+
+/*
+    This function returns true if a token kind is the reserved word of
+    a datatype (int, char or bool).
+*/
+bool Tokenization::isDatatype(TokenKind kind) {
+    return kind == TokenKind::KEYWORD_INT || kind == TokenKind::KEYWORD_CHAR ||
+           kind == TokenKind::KEYWORD_BOOL;
 }
 
 /*
-    This function displays the tokens stored in the tokenList vector.
-    If there is an error with one of the tokens, the syntax error will
-    be outputted instead.
+    This function displays the tokens stored in the tokenList vector,
+    in format. If there is an error with one of the tokens, the syntax
+    error will be outputted instead.
 */
-void Tokenization::displayTokens(const std::string &outputFilename) {
+void Tokenization::displayTokens(const std::string &outputFilename, ReportFormat format) {
     // open outFile
-    std::ofstream outFile(outputFilename);
+    ReportWriter outFile(outputFilename, format);
     
     // if there are no invalid tokens, display tokens
     if (!invalidToken && tokenList.size() != 0) {
-        outFile << "Token list:" << std::endl << std::endl;
+        if (outFile.isText()) {
+            outFile << "Token list:\n\n";
+        }
         
         for (int i = 0; i < tokenList.size(); i++) {
-            outFile << "Token type: " << tokenList.at(i).type << std::endl;
-            outFile << "Token:      " << tokenList.at(i).value << std::endl;
-            outFile << std::endl;
+            displayToken(outFile, tokenList.at(i), value(tokenList.at(i)));
         }
     }
     else {
-        outFile << "Syntax error on line " << errorLineNumber << ": ";
+        displayError(outFile);
+    }
+}
 
-        if (invalidType == "string") {
-            outFile << "unterminated string quote." << std::endl;
+/*
+    This function tokenizes the input file with tokenizeStream and
+    displays each token as it is found, in the same format as
+    displayTokens. If there is an error with one of the tokens, the
+    output file is rewritten with only the syntax error.
+*/
+void Tokenization::displayTokenStream(const std::string &inputFilename,
+                                      const std::string &outputFilename,
+                                      ReportFormat format) {
+    // open outFile
+    ReportWriter outFile(outputFilename, format);
+    bool foundToken = false;
+
+    tokenizeStream(inputFilename, [&outFile, &foundToken](const Token &newToken,
+                                                          const std::string &valueText) {
+        if (!foundToken && outFile.isText()) {
+            outFile << "Token list:\n\n";
         }
-        else {
-            outFile << "invalid " << invalidType << "." << std::endl;
+        foundToken = true;
+        displayToken(outFile, newToken, valueText);
+    });
+
+    // replace the tokens displayed so far with the error
+    if (invalidToken || !foundToken) {
+        outFile.restart();
+        displayError(outFile);
+    }
+}
+
+/*
+    This function displays one token and its value.
+*/
+void Tokenization::displayToken(ReportWriter &outFile, const Token &newToken,
+                                const std::string &valueText) {
+    if (outFile.isText()) {
+        outFile << "Token type: " << kindName(newToken.kind) << '\n';
+        outFile << "Token:      " << valueText << '\n';
+        outFile << '\n';
+        return;
+    }
+
+    outFile.beginRecord("token");
+    outFile.field("kind", kindName(newToken.kind), std::strlen(kindName(newToken.kind)));
+    outFile.field("value", valueText);
+    outFile.endRecord();
+}
+
+/*
+    This function displays the syntax error that stopped tokenizing.
+*/
+void Tokenization::displayError(ReportWriter &outFile) {
+    std::string message;
+    if (invalidType == "string") {
+        message = "unterminated string quote.";
+    }
+    else {
+        message = "invalid " + invalidType + ".";
+    }
+
+    if (outFile.isText()) {
+        outFile << "Syntax error on line " << errorLineNumber << ": " << message << '\n';
+        return;
+    }
+
+    outFile.beginRecord("error");
+    outFile.field("line", errorLineNumber);
+    outFile.field("message", message);
+    outFile.endRecord();
+}
+
+const std::size_t TokenStream::lookaheadSize;
+
+/*
+    The TokenStream constructor starts reading the source from begin
+    to end. If skipComments is true the comments are skipped while
+    reading, otherwise the source must already have them removed.
+*/
+TokenStream::TokenStream(Tokenization &tokenizer, const char* begin, const char* end,
+                         bool skipComments) :
+    tokenizer(tokenizer), rawFile(begin, end), commentSkipper(rawFile),
+    skipComments(skipComments), lookaheadStart(0), lookaheadCount(0) {
+    tokenizer.setSource(begin, end);
+
+    // check if input file is empty
+    if (begin == end) {
+        std::cout << "Input file is empty." << std::endl;
+    }
+}
+
+/*
+    This function returns the token that is ahead tokens after the
+    next one without taking it, or nullptr if the source ends first.
+    ahead has to be less than lookaheadSize.
+*/
+const Token* TokenStream::peek(std::size_t ahead) {
+    while (lookaheadCount <= ahead && lookaheadCount < lookaheadSize) {
+        if (!read(lookahead[(lookaheadStart + lookaheadCount) % lookaheadSize])) {
+            return nullptr;
         }
+        lookaheadCount++;
+    }
+
+    if (ahead >= lookaheadCount) {
+        return nullptr;
     }
+    return &lookahead[(lookaheadStart + ahead) % lookaheadSize];
+}
+
+/*
+    This function takes the next token, and returns false if there are
+    no more tokens or an invalid token was found.
+*/
+bool TokenStream::next(Token &nextToken) {
+    if (lookaheadCount > 0) {
+        nextToken = lookahead[lookaheadStart];
+        lookaheadStart = (lookaheadStart + 1) % lookaheadSize;
+        lookaheadCount--;
+        return true;
+    }
+    return read(nextToken);
+}
+
+/*
+    This function reads the rest of the source without tokenizing it,
+    so errors for comments after the last token that was taken are
+    still reported.
+*/
+void TokenStream::finish() {
+    if (skipComments) {
+        commentSkipper.finish();
+    }
+}
+
+/*
+    This function reads the next token from the source.
+*/
+bool TokenStream::read(Token &nextToken) {
+    bool foundToken = skipComments ? tokenizer.nextToken(commentSkipper, state) :
+                                     tokenizer.nextToken(rawFile, state);
+    if (!foundToken) {
+        return false;
+    }
+
+    nextToken = tokenizer.token;
+    tokenizer.storeValue(nextToken, tokenizer.tokenValue);
+    return true;
 }
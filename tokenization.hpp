@@ -4,20 +4,91 @@
 
     Tokenization header file
     Description: The Tokenization class contains functions to
-    tokenize a .c file and to display the tokens or error that
-    is found in the .c file.
+    tokenize a .c file (or source already in memory) and to display
+    the tokens or error that is found in the .c file. Tokens refer
+    to their text in the source, so a source in memory has to be
+    kept until the tokens are no longer used. Tokens only keep their
+    offset in the source, their line is looked up in a SourceMap
+    when it is needed. A token list can be updated after an edit to
+    its source by tokenizing again only around the edit.
 */
 
 #ifndef TOKENIZATION_HPP
 #define TOKENIZATION_HPP
 
+#include <cstddef>
+#include <functional>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "atomtable.hpp"
+#include "removecomments.hpp"
+#include "reportwriter.hpp"
+#include "sourcebuffer.hpp"
+#include "sourcemap.hpp"
+
+/*
+    This enumerated class contains the kinds of tokens. Reserved words
+    have kinds of their own, but are displayed as IDENTIFIER.
+*/
+enum class TokenKind : unsigned char {
+    ESCAPED_CHARACTER,
+    LEFT_PARENTHESIS,
+    RIGHT_PARENTHESIS,
+    LEFT_BRACKET,
+    RIGHT_BRACKET,
+    LEFT_BRACE,
+    RIGHT_BRACE,
+    DOUBLE_QUOTE,
+    SINGLE_QUOTE,
+    SEMICOLON,
+    COMMA,
+    ASSIGNMENT,
+    PLUS,
+    MINUS,
+    ASTERISK,
+    DIVIDE,
+    MODULO,
+    CARET,
+    LESS_THAN,
+    GREATER_THAN,
+    LESS_THAN_OR_EQUAL,
+    GREATER_THAN_OR_EQUAL,
+    BOOLEAN_AND,
+    BOOLEAN_OR,
+    BOOLEAN_NOT,
+    BOOLEAN_EQUAL,
+    NOT_EQUAL,
+    STRING,
+    INTEGER,
+    IDENTIFIER,
+    KEYWORD_INT,
+    KEYWORD_CHAR,
+    KEYWORD_BOOL,
+    KEYWORD_VOID,
+    KEYWORD_IF,
+    KEYWORD_ELSE,
+    KEYWORD_FUNCTION,
+    KEYWORD_PROCEDURE,
+    KEYWORD_PRINTF
+};
+
+/*
+    A token doesn't hold its own text. Its value is the length
+    characters at offset in the source that was tokenized, see
+    Tokenization::value. Its line and column are found from its
+    location, see Tokenization::line.
+*/
 struct Token {
-    std::string type;
-    std::string value;
-    int lineNumber;
+    TokenKind kind;
+    unsigned int offset;
+    unsigned int length;
+    // value of an INTEGER token
+    int integerValue;
+    // atom of an identifier or reserved word in the token list,
+    // AtomTable::none otherwise
+    unsigned int atom;
 };
 
 class Tokenization {
@@ -27,17 +98,160 @@ class Tokenization {
 
         // member function
         void tokenize(const std::string& inputFilename);
-        void displayTokens(const std::string &outputFilename);
+        void tokenizeSource(const std::string &sourceCode);
+        void tokenize(const char* begin, const char* end);
+        void tokenizeSkippingComments(const char* begin, const char* end);
+        void tokenizeParallel(const char* begin, const char* end, bool skipComments,
+                              unsigned int threadCount = 0,
+                              std::size_t segmentSize = 262144);
+        void edit(std::string &sourceCode, std::size_t offset, std::size_t removedLength,
+                  const std::string &insertedText);
+        void tokenizeStream(const std::string &inputFilename,
+                            const std::function<void(const Token&, const std::string&)> &consumer,
+                            std::size_t chunkSize = 65536);
+        void displayTokens(const std::string &outputFilename,
+                           ReportFormat format = ReportFormat::TEXT);
+        void displayTokenStream(const std::string &inputFilename,
+                                const std::string &outputFilename,
+                                ReportFormat format = ReportFormat::TEXT);
+        std::string value(const Token &token) const;
+        std::size_t location(const Token &token) const;
+        int line(const Token &token) const { return sourceMap.line(location(token)); }
+        int column(const Token &token) const { return sourceMap.column(location(token)); }
+        std::size_t tokenCount() const { return tokenList.size(); }
+        bool hasInvalidToken() const { return invalidToken; }
+        const Token& tokenAt(std::size_t index) const { return tokenList[index]; }
+        const AtomTable& atomTable() const { return atoms; }
+        static const char* kindName(TokenKind kind);
+        static bool isDatatype(TokenKind kind);
 
-        // declare friend class
+        // declare friend classes
         friend class ConcreteSyntaxTree;
+        friend class TokenStream;
+        friend class TokenCache;
+        friend class AbstractSyntaxTree;
 
     private:
+        /*
+            Where the tokenizer is between two calls of nextToken.
+        */
+        struct LexerState {
+            // quote that ends the string being read, 0 if none
+            char endingQuote;
+            // the closing quote of a string is the next token
+            bool closingQuote;
+            std::size_t closingQuotePosition;
+            // nextToken returns false before reading at or past this offset
+            std::size_t stopPosition;
+
+            LexerState() : endingQuote(0), closingQuote(false),
+                           closingQuotePosition(0), stopPosition(static_cast<std::size_t>(-1)) {}
+        };
+
+        /*
+            A place between two tokens where tokenizing can start over:
+            no string or comment is open there, and the token before it
+            is repeated by whitespace only if repeatable is true.
+        */
+        struct Checkpoint {
+            std::size_t position;
+            std::size_t tokenIndex;
+            bool repeatable;
+        };
+
+        // part of a source that is tokenized on its own thread
+        class Segment;
+        // checkpoints of a token list that an edit can rejoin
+        struct Resync;
+
+        // private functions
+        template <typename Reader, typename Consumer>
+        void tokenize(Reader &inFile, const Consumer &consumer);
+        template <typename Reader>
+        bool nextToken(Reader &inFile, LexerState &state);
+        template <typename Reader>
+        void tokenizeToList(Reader &inFile);
+        template <typename Reader>
+        std::size_t readTokens(Reader &inFile, LexerState &state, const Resync *resync);
+        std::size_t nextLineStart(std::size_t from) const;
+        std::vector<unsigned int> mapAtoms(const AtomTable &otherAtoms);
+        Token adoptToken(const Tokenization &lexer, const Token &otherToken,
+                         const std::vector<unsigned int> &atomMap);
+        void clearTokens();
+        void addToken(const Token &newToken, const std::string &valueText);
+        void storeValue(Token &newToken, const std::string &valueText);
+        void spillValue(Token &newToken, const std::string &valueText);
+        void setSource(const char* begin, const char* end);
+        template <typename Reader>
+        void setError(Reader &inFile, const char* type);
+        static void displayToken(ReportWriter &outFile, const Token &newToken,
+                                 const std::string &valueText);
+        void displayError(ReportWriter &outFile);
+
         std::vector<Token> tokenList;
+        // names of the identifiers and reserved words in tokenList
+        AtomTable atoms;
+        // source the token offsets refer to
+        SourceBuffer sourceFile;
+        const char* source;
+        std::size_t sourceLength;
+        // values that aren't found as they are in the source, and the
+        // offset in extraValues and location in the source of each one
+        std::string extraValues;
+        std::vector<std::pair<unsigned int, unsigned int>> extraLocations;
+        // lines of the source
+        SourceMap sourceMap;
+        // where an edit can start tokenizing again, in order
+        std::vector<Checkpoint> checkpoints;
+        bool skippingComments;
+        static const std::size_t checkpointSpacing = 1024;
+        // lines of the unterminated comments that were reported
+        std::vector<int> commentErrors;
         Token token;
+        std::string tokenValue;
         bool invalidToken;
         std::string invalidType;
         int errorLineNumber;
+        std::size_t errorOffset;
+};
+
+/*
+    The TokenStream class hands the tokens of a source to the parser
+    one at a time. A token is only read from the source when it is
+    asked for, so the tokens are never all kept in memory, and reading
+    stops as soon as the parser stops asking. Up to lookaheadSize
+    tokens can be looked at with peek before they are taken with next.
+    The values of the tokens are kept by the tokenizer, which also
+    records an invalid token.
+*/
+class TokenStream {
+    public:
+        // constructor
+        TokenStream(Tokenization &tokenizer, const char* begin, const char* end,
+                    bool skipComments);
+
+        // member functions
+        const Token* peek(std::size_t ahead = 0);
+        bool next(Token &nextToken);
+        void finish();
+
+        static const std::size_t lookaheadSize = 4;
+
+        // declare friend class
+        friend class ConcreteSyntaxTree;
+
+    private:
+        bool read(Token &nextToken);
+
+        Tokenization &tokenizer;
+        SourceReader rawFile;
+        CommentSkipper<SourceReader> commentSkipper;
+        bool skipComments;
+        Tokenization::LexerState state;
+        // tokens that were peeked but not taken yet
+        Token lookahead[lookaheadSize];
+        std::size_t lookaheadStart;
+        std::size_t lookaheadCount;
 };
 
 #endif